@@ -1,7 +1,26 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "HappyHazard.h"
+#include "Debug/HappyStartupProfiler.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, HappyHazard, "HappyHazard" );
- 
\ No newline at end of file
+class FHappyHazardModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FHappyStartupProfiler::Get().NotifyModuleStartup();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FHappyHazardModule, HappyHazard, "HappyHazard" );
+
+LLM_DEFINE_TAG(HappyHazard);
+LLM_DEFINE_TAG(HappyHazard_Character, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Weapon, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Item, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_UI, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Corpse, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Audio, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Events, NAME_None, TEXT("HappyHazard"));
+LLM_DEFINE_TAG(HappyHazard_Replay, NAME_None, TEXT("HappyHazard"));
@@ -3,3 +3,19 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+
+// stat page for our own gameplay systems ("stat HappyHazard")
+DECLARE_STATS_GROUP(TEXT("HappyHazard"), STATGROUP_HappyHazard, STATCAT_Advanced);
+
+// LLM tags for our own gameplay systems, run with -llm and use HappyHazard.MemReport
+LLM_DECLARE_TAG_API(HappyHazard, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Character, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Weapon, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Item, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_UI, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Corpse, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Audio, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Events, HAPPYHAZARD_API);
+LLM_DECLARE_TAG_API(HappyHazard_Replay, HAPPYHAZARD_API);
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Audio/AnimNotify_HappyFootstep.h"
+#include "Audio/HappyAudioSubsystem.h"
+#include "Character/HappyHazardCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+void UAnimNotify_HappyFootstep::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	Super::Notify(MeshComp, Animation, EventReference);
+
+	if (!MeshComp || !Sound) return;
+
+	UWorld* World = MeshComp->GetWorld();
+	if (!World) return;
+
+	const FVector Location = MeshComp->DoesSocketExist(FootSocketName) ? MeshComp->GetSocketLocation(FootSocketName) : MeshComp->GetComponentLocation();
+
+	float VolumeMultiplier = 1.f;
+	if (const AHappyHazardCharacter* Character = Cast<AHappyHazardCharacter>(MeshComp->GetOwner()))
+	{
+		if (Character->GetIsShifting())
+		{
+			VolumeMultiplier = ShiftVolumeMultiplier;
+		}
+	}
+
+	if (UHappyAudioSubsystem* AudioSubsystem = World->GetSubsystem<UHappyAudioSubsystem>())
+	{
+		AudioSubsystem->PlaySound(Sound, EHappySoundCategory::Footstep, Location, VolumeMultiplier);
+	}
+	else if (World->WorldType == EWorldType::EditorPreview)
+	{
+		// animation editor preview has no pool, still let animators hear the timing
+		UGameplayStatics::PlaySoundAtLocation(World, Sound, Location, VolumeMultiplier);
+	}
+}
+
+FString UAnimNotify_HappyFootstep::GetNotifyName_Implementation() const
+{
+	return TEXT("Happy Footstep");
+}
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Audio/HappyAudioSubsystem.h"
+#include "HappyHazard.h"
+#include "Battle/Weapon.h"
+#include "Components/AudioComponent.h"
+#include "Event/HappyGameplayEventBus.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Audio Pool Tick"), STAT_HappyAudioTick, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Active Voices"), STAT_HappyAudioActiveVoices, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Culled Requests"), STAT_HappyAudioCulled, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool In Use"), STAT_HappyAudioPoolInUse, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Pool Size"), STAT_HappyAudioPoolSize, STATGROUP_HappyHazard);
+
+void UHappyAudioSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UHappyGameplayEventBus* EventBus = Collection.InitializeDependency<UHappyGameplayEventBus>())
+	{
+		EventBus->OnEvents(EHappyEventChannel::Weapon).AddUObject(this, &UHappyAudioSubsystem::HandleWeaponEvents);
+	}
+}
+
+void UHappyAudioSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LLM_SCOPE_BYTAG(HappyHazard_Audio);
+
+	// warm the pool so the first gunfight doesn't create components mid frame
+	for (int32 Index = 0; Index < FMath::Min(InitialPoolSize, MaxPoolSize); Index++)
+	{
+		Pool.Add(CreatePooledComponent());
+		PoolCategories.Add(EHappySoundCategory::Effect);
+		PoolInUse.Add(false);
+		FreeIndices.Add(Index);
+	}
+}
+
+void UHappyAudioSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : Pool)
+	{
+		if (Component)
+		{
+			Component->OnAudioFinishedNative.RemoveAll(this);
+			Component->DestroyComponent();
+		}
+	}
+
+	Pool.Reset();
+	PoolCategories.Reset();
+	PoolInUse.Reset();
+	FreeIndices.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UHappyAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyAudioSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_HappyAudioTick);
+}
+
+void UHappyAudioSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	int32 NumActive = 0;
+	for (int32 Count : ActiveCounts)
+	{
+		NumActive += Count;
+	}
+
+	int32 NumPooled = 0;
+	for (UAudioComponent* Component : Pool)
+	{
+		if (Component) NumPooled++;
+	}
+
+	SET_DWORD_STAT(STAT_HappyAudioActiveVoices, NumActive);
+	SET_DWORD_STAT(STAT_HappyAudioCulled, CulledThisFrame);
+	SET_DWORD_STAT(STAT_HappyAudioPoolInUse, NumPooled - FreeIndices.Num());
+	SET_DWORD_STAT(STAT_HappyAudioPoolSize, NumPooled);
+
+	CulledThisFrame = 0;
+
+	// listener for next frame's distance culling
+	bHasListener = false;
+	if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		FVector FrontDir;
+		FVector RightDir;
+		PlayerController->GetAudioListenerPosition(ListenerLocation, FrontDir, RightDir);
+		bHasListener = true;
+	}
+}
+
+UAudioComponent* UHappyAudioSubsystem::PlaySound(USoundBase* Sound, EHappySoundCategory Category, const FVector& Location, float VolumeMultiplier)
+{
+	if (!Sound) return nullptr;
+
+	const FHappySoundCategorySettings& Settings = GetSettings(Category);
+	const int32 CategoryIndex = static_cast<int32>(Category);
+
+	if (bHasListener && FVector::DistSquared(ListenerLocation, Location) > FMath::Square(Settings.MaxDistance))
+	{
+		CulledThisFrame++;
+		return nullptr;
+	}
+
+	if (ActiveCounts[CategoryIndex] >= Settings.MaxConcurrent)
+	{
+		CulledThisFrame++;
+		return nullptr;
+	}
+
+	const int32 PoolIndex = AcquireComponent();
+	if (PoolIndex == INDEX_NONE)
+	{
+		CulledThisFrame++;
+		return nullptr;
+	}
+
+	UAudioComponent* Component = Pool[PoolIndex];
+	PoolCategories[PoolIndex] = Category;
+	ActiveCounts[CategoryIndex]++;
+
+	Component->SetSound(Sound);
+	Component->SetWorldLocation(Location);
+	Component->SetVolumeMultiplier(VolumeMultiplier);
+	Component->Play();
+
+	return Component;
+}
+
+void UHappyAudioSubsystem::SetMaxPoolSize(int32 InMaxPoolSize)
+{
+	MaxPoolSize = FMath::Max(InMaxPoolSize, 1);
+
+	// free slots past the new size go now, busy ones when they finish
+	for (int32 Index = FreeIndices.Num() - 1; Index >= 0; Index--)
+	{
+		const int32 PoolIndex = FreeIndices[Index];
+		if (PoolIndex >= MaxPoolSize)
+		{
+			FreeIndices.RemoveAtSwap(Index);
+			Pool[PoolIndex]->DestroyComponent();
+			Pool[PoolIndex] = nullptr;
+		}
+	}
+}
+
+int32 UHappyAudioSubsystem::AcquireComponent()
+{
+	LLM_SCOPE_BYTAG(HappyHazard_Audio);
+
+	if (FreeIndices.Num() > 0)
+	{
+		const int32 PoolIndex = FreeIndices.Pop(EAllowShrinking::No);
+		PoolInUse[PoolIndex] = true;
+		return PoolIndex;
+	}
+
+	// grow into an empty slot, or append while under budget
+	int32 PoolIndex = Pool.IndexOfByKey(nullptr);
+	if (PoolIndex == INDEX_NONE || PoolIndex >= MaxPoolSize)
+	{
+		if (Pool.Num() >= MaxPoolSize) return INDEX_NONE;
+
+		PoolIndex = Pool.Add(nullptr);
+		PoolCategories.Add(EHappySoundCategory::Effect);
+		PoolInUse.Add(false);
+	}
+
+	Pool[PoolIndex] = CreatePooledComponent();
+	PoolInUse[PoolIndex] = true;
+	return PoolIndex;
+}
+
+void UHappyAudioSubsystem::ReleaseComponent(int32 PoolIndex)
+{
+	PoolInUse[PoolIndex] = false;
+	ActiveCounts[static_cast<int32>(PoolCategories[PoolIndex])]--;
+
+	if (PoolIndex >= MaxPoolSize)
+	{
+		Pool[PoolIndex]->DestroyComponent();
+		Pool[PoolIndex] = nullptr;
+		return;
+	}
+
+	FreeIndices.Add(PoolIndex);
+}
+
+UAudioComponent* UHappyAudioSubsystem::CreatePooledComponent()
+{
+	UAudioComponent* Component = NewObject<UAudioComponent>(GetWorld()->GetWorldSettings());
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bStopWhenOwnerDestroyed = false;
+	Component->OnAudioFinishedNative.AddUObject(this, &UHappyAudioSubsystem::OnPooledAudioFinished);
+	Component->RegisterComponentWithWorld(GetWorld());
+
+	return Component;
+}
+
+void UHappyAudioSubsystem::OnPooledAudioFinished(UAudioComponent* Component)
+{
+	const int32 PoolIndex = Pool.IndexOfByKey(Component);
+	if (PoolIndex != INDEX_NONE && PoolInUse[PoolIndex])
+	{
+		ReleaseComponent(PoolIndex);
+	}
+}
+
+void UHappyAudioSubsystem::HandleWeaponEvents(TConstArrayView<FHappyGameplayEvent> Events)
+{
+	for (const FHappyGameplayEvent& Event : Events)
+	{
+		if (Event.Type != EHappyEventType::Fire) continue;
+
+		if (AWeapon* Weapon = Cast<AWeapon>(Event.Source.Get()))
+		{
+			PlaySound(Weapon->GetFireSound(), EHappySoundCategory::Gunfire, FVector(Event.Location));
+		}
+	}
+}
+
+const FHappySoundCategorySettings& UHappyAudioSubsystem::GetSettings(EHappySoundCategory Category) const
+{
+	for (const FHappySoundCategorySettings& Settings : CategorySettings)
+	{
+		if (Settings.Category == Category) return Settings;
+	}
+
+	static const FHappySoundCategorySettings DefaultSettings;
+	return DefaultSettings;
+}
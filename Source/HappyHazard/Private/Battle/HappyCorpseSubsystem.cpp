@@ -0,0 +1,379 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Battle/HappyCorpseSubsystem.h"
+#include "HappyHazard.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Corpse Tick"), STAT_HappyCorpseTick, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses Simulating"), STAT_HappyCorpsesSimulating, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses Sleeping"), STAT_HappyCorpsesSleeping, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses Frozen"), STAT_HappyCorpsesFrozen, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpse Simulated Bodies"), STAT_HappyCorpseBodies, STATGROUP_HappyHazard);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Physics Step (ms)"), STAT_HappyPhysicsStepMs, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyCorpse, Log, All);
+
+static FAutoConsoleCommandWithWorld CmdHappyCorpseKillAll(
+	TEXT("HappyHazard.Corpse.KillAll"),
+	TEXT("Apply lethal damage to every character the player doesn't control, to exercise the corpse budget."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World) return;
+
+		TArray<ACharacter*> Victims;
+		for (TActorIterator<ACharacter> It(World); It; ++It)
+		{
+			if (!It->IsPlayerControlled())
+			{
+				Victims.Add(*It);
+			}
+		}
+
+		for (ACharacter* Victim : Victims)
+		{
+			UGameplayStatics::ApplyDamage(Victim, 1.0e6f, nullptr, nullptr, nullptr);
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// FHappyCorpsePhysicsTimerTickFunction
+
+void FHappyCorpsePhysicsTimerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (!Target) return;
+
+	if (bPhysicsEnd)
+	{
+		Target->MarkPhysicsEnd();
+	}
+	else
+	{
+		Target->MarkPhysicsStart();
+	}
+}
+
+FString FHappyCorpsePhysicsTimerTickFunction::DiagnosticMessage()
+{
+	return TEXT("FHappyCorpsePhysicsTimerTickFunction");
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UHappyCorpseSubsystem
+
+void UHappyCorpseSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	LLM_SCOPE_BYTAG(HappyHazard_Corpse);
+
+	Super::Initialize(Collection);
+
+	Slots.SetNum(FMath::Max(MaxLiveCorpses, 1));
+}
+
+void UHappyCorpseSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// start in the start physics group just before the world kicks off the step, stop right after its end physics tick,
+	// so the remaining pre physics and during physics game thread work isn't counted
+	PhysicsStartTickFunction.bCanEverTick = true;
+	PhysicsStartTickFunction.bStartWithTickEnabled = true;
+	PhysicsStartTickFunction.TickGroup = TG_StartPhysics;
+	PhysicsStartTickFunction.Target = this;
+	PhysicsStartTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+	InWorld.StartPhysicsTickFunction.AddPrerequisite(this, PhysicsStartTickFunction);
+
+	PhysicsEndTickFunction.bCanEverTick = true;
+	PhysicsEndTickFunction.bStartWithTickEnabled = true;
+	PhysicsEndTickFunction.TickGroup = TG_EndPhysics;
+	PhysicsEndTickFunction.bPhysicsEnd = true;
+	PhysicsEndTickFunction.Target = this;
+	PhysicsEndTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+	PhysicsEndTickFunction.AddPrerequisite(&InWorld, InWorld.EndPhysicsTickFunction);
+}
+
+void UHappyCorpseSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->StartPhysicsTickFunction.RemovePrerequisite(this, PhysicsStartTickFunction);
+		PhysicsEndTickFunction.RemovePrerequisite(World, World->EndPhysicsTickFunction);
+	}
+
+	PhysicsStartTickFunction.UnRegisterTickFunction();
+	PhysicsStartTickFunction.Target = nullptr;
+	PhysicsEndTickFunction.UnRegisterTickFunction();
+	PhysicsEndTickFunction.Target = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UHappyCorpseSubsystem::MarkPhysicsStart()
+{
+	PhysicsStartTime = FPlatformTime::Seconds();
+}
+
+void UHappyCorpseSubsystem::MarkPhysicsEnd()
+{
+	// wall time of the whole step, read it against Corpse Simulated Bodies
+	SET_FLOAT_STAT(STAT_HappyPhysicsStepMs, (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0);
+}
+
+bool UHappyCorpseSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyCorpseSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_HappyCorpseTick);
+}
+
+void UHappyCorpseSubsystem::AddCorpse(ACharacter* DeadCharacter)
+{
+	if (!DeadCharacter || !DeadCharacter->GetMesh()) return;
+
+	// already a corpse, a second ragdoll start would reset its slot
+	if (Slots.ContainsByPredicate([DeadCharacter](const FCorpseSlot& Slot) { return Slot.Character.Get() == DeadCharacter; })) return;
+
+	LLM_SCOPE_BYTAG(HappyHazard_Corpse);
+
+	int32 SlotIndex = FindFreeSlot();
+	if (SlotIndex == INDEX_NONE)
+	{
+		// all slots are taken, the oldest corpse is destroyed and the new one takes its slot
+		SlotIndex = FindOldestSlot(false);
+		DestroyCorpse(Slots[SlotIndex]);
+	}
+
+	if (MaxSimulatingCorpses > 0 && CountSimulating() >= MaxSimulatingCorpses)
+	{
+		int32 OldestSimulating = FindOldestSlot(true);
+		if (OldestSimulating != INDEX_NONE)
+		{
+			FreezeCorpse(Slots[OldestSimulating]);
+		}
+	}
+
+	// a zero simulating budget freezes the corpse in the pose it died in
+	const bool bSimulate = MaxSimulatingCorpses > 0;
+
+	FCorpseSlot& Slot = Slots[SlotIndex];
+	Slot.Character = DeadCharacter;
+	Slot.State = ECorpseState::Simulating;
+	Slot.AddedTime = GetWorld()->GetTimeSeconds();
+	Slot.SettledTime = 0.f;
+
+	StartRagdoll(DeadCharacter, bSimulate);
+
+	if (!bSimulate)
+	{
+		FreezeCorpse(Slot);
+	}
+}
+
+void UHappyCorpseSubsystem::SetBudget(int32 InMaxSimulatingCorpses, int32 InMaxLiveCorpses)
+{
+	MaxSimulatingCorpses = FMath::Max(InMaxSimulatingCorpses, 0);
+	MaxLiveCorpses = FMath::Max(InMaxLiveCorpses, 1);
+
+	LLM_SCOPE_BYTAG(HappyHazard_Corpse);
+
+	EnforceBudget();
+}
+
+void UHappyCorpseSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	int32 NumSimulating = 0;
+	int32 NumSleeping = 0;
+	int32 NumFrozen = 0;
+	int32 NumBodies = 0;
+
+	for (FCorpseSlot& Slot : Slots)
+	{
+		if (!Slot.IsInUse()) continue;
+
+		USkeletalMeshComponent* Mesh = Slot.Character->GetMesh();
+
+		switch (Slot.State)
+		{
+		case ECorpseState::Simulating:
+			if (Mesh->GetPhysicsLinearVelocity().Size() <= SettleSpeed)
+			{
+				Slot.SettledTime += DeltaTime;
+			}
+			else
+			{
+				Slot.SettledTime = 0.f;
+			}
+
+			if (Slot.SettledTime >= SleepDelay)
+			{
+				SleepCorpse(Slot);
+			}
+			break;
+
+		case ECorpseState::Sleeping:
+			Slot.SettledTime += DeltaTime;
+
+			if (Slot.SettledTime >= SleepDelay + FreezeDelay)
+			{
+				FreezeCorpse(Slot);
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		switch (Slot.State)
+		{
+		case ECorpseState::Simulating:
+			NumSimulating++;
+			NumBodies += Mesh->Bodies.Num();
+			break;
+		case ECorpseState::Sleeping:
+			NumSleeping++;
+			break;
+		case ECorpseState::Frozen:
+			NumFrozen++;
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_HappyCorpsesSimulating, NumSimulating);
+	SET_DWORD_STAT(STAT_HappyCorpsesSleeping, NumSleeping);
+	SET_DWORD_STAT(STAT_HappyCorpsesFrozen, NumFrozen);
+	SET_DWORD_STAT(STAT_HappyCorpseBodies, NumBodies);
+}
+
+void UHappyCorpseSubsystem::StartRagdoll(ACharacter* DeadCharacter, bool bSimulate)
+{
+	DeadCharacter->DetachFromControllerPendingDestroy();
+	DeadCharacter->GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	DeadCharacter->GetCharacterMovement()->DisableMovement();
+	DeadCharacter->GetCharacterMovement()->SetComponentTickEnabled(false);
+
+	if (!bSimulate) return;
+
+	USkeletalMeshComponent* Mesh = DeadCharacter->GetMesh();
+	Mesh->SetCollisionProfileName(TEXT("Ragdoll"));
+	Mesh->SetAllBodiesSimulatePhysics(true);
+	Mesh->SetSimulatePhysics(true);
+	Mesh->WakeAllRigidBodies();
+	Mesh->bBlendPhysics = true;
+}
+
+void UHappyCorpseSubsystem::SleepCorpse(FCorpseSlot& Slot)
+{
+	Slot.Character->GetMesh()->PutAllRigidBodiesToSleep();
+	Slot.State = ECorpseState::Sleeping;
+}
+
+void UHappyCorpseSubsystem::FreezeCorpse(FCorpseSlot& Slot)
+{
+	ACharacter* Corpse = Slot.Character.Get();
+	USkeletalMeshComponent* Mesh = Corpse->GetMesh();
+
+	// stop refreshing bones first so the last simulated pose stays on the mesh
+	Mesh->bPauseAnims = true;
+	Mesh->bNoSkeletonUpdate = true;
+	Mesh->SetComponentTickEnabled(false);
+
+	Mesh->SetAllBodiesSimulatePhysics(false);
+	Mesh->SetSimulatePhysics(false);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	Corpse->SetActorTickEnabled(false);
+
+	Slot.State = ECorpseState::Frozen;
+}
+
+void UHappyCorpseSubsystem::DestroyCorpse(FCorpseSlot& Slot)
+{
+	if (ACharacter* Corpse = Slot.Character.Get())
+	{
+		Corpse->Destroy();
+	}
+
+	Slot = FCorpseSlot();
+}
+
+int32 UHappyCorpseSubsystem::FindFreeSlot() const
+{
+	for (int32 Index = 0; Index < Slots.Num(); Index++)
+	{
+		if (!Slots[Index].IsInUse()) return Index;
+	}
+
+	return INDEX_NONE;
+}
+
+int32 UHappyCorpseSubsystem::FindOldestSlot(bool bSimulatingOnly) const
+{
+	int32 OldestIndex = INDEX_NONE;
+
+	for (int32 Index = 0; Index < Slots.Num(); Index++)
+	{
+		const FCorpseSlot& Slot = Slots[Index];
+		if (!Slot.IsInUse()) continue;
+		if (bSimulatingOnly && Slot.State != ECorpseState::Simulating) continue;
+
+		if (OldestIndex == INDEX_NONE || Slot.AddedTime < Slots[OldestIndex].AddedTime)
+		{
+			OldestIndex = Index;
+		}
+	}
+
+	return OldestIndex;
+}
+
+int32 UHappyCorpseSubsystem::CountSimulating() const
+{
+	int32 Count = 0;
+
+	for (const FCorpseSlot& Slot : Slots)
+	{
+		if (Slot.IsInUse() && Slot.State == ECorpseState::Simulating)
+		{
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+void UHappyCorpseSubsystem::EnforceBudget()
+{
+	while (CountSimulating() > MaxSimulatingCorpses)
+	{
+		FreezeCorpse(Slots[FindOldestSlot(true)]);
+	}
+
+	int32 NumLive = Slots.FilterByPredicate([](const FCorpseSlot& Slot) { return Slot.IsInUse(); }).Num();
+	int32 NumDestroyed = 0;
+	for (; NumLive > MaxLiveCorpses; NumLive--)
+	{
+		DestroyCorpse(Slots[FindOldestSlot(false)]);
+		NumDestroyed++;
+	}
+
+	// live corpses go to the front so resizing the pool only drops free slots
+	Slots.StableSort([](const FCorpseSlot& A, const FCorpseSlot& B) { return A.IsInUse() && !B.IsInUse(); });
+	Slots.SetNum(MaxLiveCorpses);
+
+	if (NumDestroyed > 0)
+	{
+		UE_LOG(LogHappyCorpse, Log, TEXT("Destroyed %d corpses for the new budget of %d live"), NumDestroyed, MaxLiveCorpses);
+	}
+
+	UE_LOG(LogHappyCorpse, Verbose, TEXT("Corpse budget set to %d simulating / %d live"), MaxSimulatingCorpses, MaxLiveCorpses);
+}
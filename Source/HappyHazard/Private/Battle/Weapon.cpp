@@ -2,11 +2,14 @@
 
 
 #include "Battle/Weapon.h"
+#include "HappyHazard.h"
 #include "Components/BoxComponent.h"
 
 // Sets default values
 AWeapon::AWeapon()
 {
+	LLM_SCOPE_BYTAG(HappyHazard_Weapon);
+
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -0,0 +1,486 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/HappyCharacterBatchSubsystem.h"
+#include "HappyHazard.h"
+#include "Character/HappyHazardCharacter.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Batch Gather"), STAT_HappyCharacterBatchGather, STATGROUP_HappyHazard);
+DECLARE_CYCLE_STAT(TEXT("Character Batch Solve"), STAT_HappyCharacterBatchSolve, STATGROUP_HappyHazard);
+DECLARE_CYCLE_STAT(TEXT("Character Batch Apply"), STAT_HappyCharacterBatchApply, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Characters"), STAT_HappyBatchedCharacters, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyCharacterBatch, Log, All);
+
+static TAutoConsoleVariable<bool> CVarHappyBatchCharacterTick(
+	TEXT("HappyHazard.BatchCharacterTick"),
+	true,
+	TEXT("Update character aim, move speed and rotation in one batched pass instead of in each actor tick.\n")
+	TEXT("Read when a character begins play."));
+
+static TAutoConsoleVariable<int32> CVarHappyBatchMinParallel(
+	TEXT("HappyHazard.BatchCharacterTick.MinParallel"),
+	64,
+	TEXT("Below this many characters the batch is solved on the game thread only."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHappyBenchBatchTick(
+	TEXT("HappyHazard.BenchBatchTick"),
+	TEXT("Compare game thread frame time with characters ticking themselves against the batched update.\n")
+	TEXT("Each count runs 120 frames per actor, then 120 frames batched, the result is logged when done.\n")
+	TEXT("Usage: HappyHazard.BenchBatchTick [Count ...] (default 50 200 1000)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UHappyCharacterBatchSubsystem* Batch = World ? World->GetSubsystem<UHappyCharacterBatchSubsystem>() : nullptr;
+		if (!Batch) return;
+
+		TArray<int32> Counts = { 50, 200, 1000 };
+		if (Args.Num() > 0)
+		{
+			Counts.Reset();
+			for (const FString& Arg : Args)
+			{
+				Counts.Add(FCString::Atoi(*Arg));
+			}
+		}
+
+		Batch->StartBenchmark(Counts, 120);
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// HappyCharacterLogic
+
+float HappyCharacterLogic::StepAimingPercent(float AimingPercent, bool bAiming, float DeltaTime)
+{
+	AimingPercent += bAiming ? DeltaTime * 5 : -DeltaTime * 5;
+
+	return FMath::Clamp(AimingPercent, 0.f, 1.f);
+}
+
+void HappyCharacterLogic::SolveCameraBoom(const FHappyCharacterTuning& Tuning, float AimingPercent, bool bAiming, float AimPitch, float& OutArmLength, FVector& OutSocketOffset)
+{
+	if (!bAiming)
+	{
+		OutArmLength = FMath::Lerp(Tuning.DefaultArmLength, Tuning.AimArmLength, AimingPercent);
+		OutSocketOffset = FMath::Lerp(Tuning.DefaultSocketPosition, Tuning.AimSocketPosition, AimingPercent);
+		return;
+	}
+
+	// while aiming the camera follows the pitch instead
+	float Pitch = AimPitch / 90;
+
+	if (Pitch >= 0)
+	{
+		OutArmLength = FMath::Lerp(Tuning.AimArmLength, Tuning.AimUpArmLength, Pitch);
+		OutSocketOffset = FMath::Lerp(Tuning.AimSocketPosition, Tuning.AimUpSocketPosition, Pitch);
+	}
+	else
+	{
+		Pitch = FMath::Abs(Pitch);
+		OutArmLength = FMath::Lerp(Tuning.AimArmLength, Tuning.AimDownArmLength, Pitch);
+		OutSocketOffset = FMath::Lerp(Tuning.AimSocketPosition, Tuning.AimDownSocketPosition, Pitch);
+	}
+}
+
+float HappyCharacterLogic::StepMoveInput(float CurrentInput, float TargetInput)
+{
+	// turning around is slower than speeding up in the same direction
+	float Alpha = (TargetInput * CurrentInput < 0) ? 0.03f : 0.1f;
+
+	return FMath::Lerp(CurrentInput, TargetInput, Alpha);
+}
+
+float HappyCharacterLogic::SolveMoveSpeed(const FHappyCharacterTuning& Tuning, bool bNowAiming, bool bNowShifting)
+{
+	if (bNowAiming)
+	{
+		return Tuning.AimMoveSpeed;
+	}
+	else if (bNowShifting)
+	{
+		return Tuning.ShiftMoveSpeed;
+	}
+
+	return Tuning.DefaultMoveSpeed;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHappyCharacterBatchTickFunction
+
+void FHappyCharacterBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->UpdateBatch(DeltaTime);
+	}
+}
+
+FString FHappyCharacterBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FHappyCharacterBatchTickFunction");
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UHappyCharacterBatchSubsystem
+
+namespace
+{
+	enum EHappyBatchFlags : uint8
+	{
+		BatchFlag_Aiming = 1 << 0,		// GetIsAiming(), aiming and on the ground
+		BatchFlag_NowAiming = 1 << 1,	// aim button held
+		BatchFlag_NowShifting = 1 << 2,
+		BatchFlag_Stopped = 1 << 3,
+		BatchFlag_HasController = 1 << 4,
+		BatchFlag_Skipped = 1 << 5,		// inside its tick interval, nothing is solved or written this frame
+	};
+}
+
+bool UHappyCharacterBatchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHappyCharacterBatchSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	BatchTickFunction.bCanEverTick = true;
+	BatchTickFunction.bStartWithTickEnabled = true;
+	BatchTickFunction.TickGroup = TG_PrePhysics;
+	BatchTickFunction.Target = this;
+	BatchTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UHappyCharacterBatchSubsystem::Deinitialize()
+{
+	BatchTickFunction.UnRegisterTickFunction();
+	BatchTickFunction.Target = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UHappyCharacterBatchSubsystem::RegisterCharacter(AHappyHazardCharacter* Character)
+{
+	if (!Character || !CVarHappyBatchCharacterTick.GetValueOnGameThread()) return false;
+
+	if (Characters.Contains(Character)) return true;
+
+	LLM_SCOPE_BYTAG(HappyHazard_Character);
+
+	Characters.Add(Character);
+	Tunings.Add(Character->GetTuning());
+	PendingTimes.Add(0.f);
+
+	// the batch does everything the actor tick did, so the actor tick function isn't dispatched at all
+	Character->bBatchTicked = true;
+	Character->SetActorTickEnabled(false);
+
+	// controller input -> batch -> character movement, all in the same frame
+	NotifyControllerChanged(Character);
+	Character->GetCharacterMovement()->PrimaryComponentTick.AddPrerequisite(this, BatchTickFunction);
+
+	return true;
+}
+
+void UHappyCharacterBatchSubsystem::NotifyControllerChanged(AHappyHazardCharacter* Character)
+{
+	if (!Character || !Character->bBatchTicked) return;
+
+	// a previous controller is left as a prerequisite, it only orders the batch after it
+	if (AController* CharacterController = Character->GetController())
+	{
+		BatchTickFunction.AddPrerequisite(CharacterController, CharacterController->PrimaryActorTick);
+	}
+}
+
+void UHappyCharacterBatchSubsystem::RefreshTuning(AHappyHazardCharacter* Character)
+{
+	const int32 Index = Characters.IndexOfByKey(Character);
+	if (Index != INDEX_NONE)
+	{
+		Tunings[Index] = Character->GetTuning();
+	}
+}
+
+void UHappyCharacterBatchSubsystem::UnregisterCharacter(AHappyHazardCharacter* Character)
+{
+	int32 Index = Characters.IndexOfByKey(Character);
+	if (Index == INDEX_NONE) return;
+
+	Characters.RemoveAtSwap(Index);
+	Tunings.RemoveAtSwap(Index);
+	PendingTimes.RemoveAtSwap(Index);
+
+	Character->bBatchTicked = false;
+	Character->SetActorTickEnabled(true);
+
+	Character->GetCharacterMovement()->PrimaryComponentTick.RemovePrerequisite(this, BatchTickFunction);
+}
+
+void UHappyCharacterBatchSubsystem::UpdateBatch(float DeltaTime)
+{
+	TickBenchmark();
+
+	// characters destroyed without EndPlay (level streaming out, etc.)
+	for (int32 Index = Characters.Num() - 1; Index >= 0; Index--)
+	{
+		if (!Characters[Index].IsValid())
+		{
+			Characters.RemoveAtSwap(Index);
+			Tunings.RemoveAtSwap(Index);
+			PendingTimes.RemoveAtSwap(Index);
+		}
+	}
+
+	GatherCharacters(DeltaTime);
+	SolveCharacters();
+	ApplyCharacters();
+
+	SET_DWORD_STAT(STAT_HappyBatchedCharacters, Characters.Num());
+}
+
+void UHappyCharacterBatchSubsystem::GatherCharacters(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HappyCharacterBatchGather);
+	LLM_SCOPE_BYTAG(HappyHazard_Character);
+
+	const int32 Num = Characters.Num();
+
+	Flags.SetNumUninitialized(Num);
+	DeltaTimes.SetNumUninitialized(Num);
+	AimPitches.SetNumUninitialized(Num);
+	ControlYaws.SetNumUninitialized(Num);
+	AimingPercents.SetNumUninitialized(Num);
+	MoveXInputs.SetNumUninitialized(Num);
+	MoveYInputs.SetNumUninitialized(Num);
+	ArmLengths.SetNumUninitialized(Num);
+	SocketOffsets.SetNumUninitialized(Num);
+	MoveSpeeds.SetNumUninitialized(Num);
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		AHappyHazardCharacter* Character = Characters[Index].Get();
+
+		// throttled by the performance governor the same way the actor tick is
+		PendingTimes[Index] += DeltaTime;
+		if (PendingTimes[Index] < Character->GetActorTickInterval())
+		{
+			Flags[Index] = BatchFlag_Skipped;
+			continue;
+		}
+
+		DeltaTimes[Index] = PendingTimes[Index];
+		PendingTimes[Index] = 0.f;
+
+		uint8 CharacterFlags = 0;
+		if (Character->GetIsAiming()) CharacterFlags |= BatchFlag_Aiming;
+		if (Character->bNowAiming) CharacterFlags |= BatchFlag_NowAiming;
+		if (Character->bNowShifting) CharacterFlags |= BatchFlag_NowShifting;
+		if (Character->GetCharacterMovement()->Velocity.Length() <= 0) CharacterFlags |= BatchFlag_Stopped;
+
+		if (AController* CharacterController = Character->GetController())
+		{
+			CharacterFlags |= BatchFlag_HasController;
+			ControlYaws[Index] = CharacterController->GetControlRotation().Yaw;
+		}
+
+		Flags[Index] = CharacterFlags;
+		AimPitches[Index] = Character->GetAimPitch();
+		AimingPercents[Index] = Character->AimingPercent;
+		MoveXInputs[Index] = Character->moveXInput;
+		MoveYInputs[Index] = Character->moveYInput;
+	}
+}
+
+void UHappyCharacterBatchSubsystem::SolveCharacters()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HappyCharacterBatchSolve);
+
+	const int32 Num = Characters.Num();
+	const EParallelForFlags ParallelFlags = (Num < CVarHappyBatchMinParallel.GetValueOnGameThread()) ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+	ParallelFor(Num, [this](int32 Index)
+	{
+		const uint8 CharacterFlags = Flags[Index];
+		if (CharacterFlags & BatchFlag_Skipped) return;
+
+		const float DeltaTime = DeltaTimes[Index];
+		const bool bAiming = (CharacterFlags & BatchFlag_Aiming) != 0;
+		const FHappyCharacterTuning& Tuning = Tunings[Index];
+
+		if (CharacterFlags & BatchFlag_Stopped)
+		{
+			MoveXInputs[Index] = HappyCharacterLogic::StepMoveInput(MoveXInputs[Index], 0.f);
+			MoveYInputs[Index] = HappyCharacterLogic::StepMoveInput(MoveYInputs[Index], 0.f);
+		}
+
+		AimingPercents[Index] = HappyCharacterLogic::StepAimingPercent(AimingPercents[Index], bAiming, DeltaTime);
+		HappyCharacterLogic::SolveCameraBoom(Tuning, AimingPercents[Index], bAiming, AimPitches[Index], ArmLengths[Index], SocketOffsets[Index]);
+		MoveSpeeds[Index] = HappyCharacterLogic::SolveMoveSpeed(Tuning, (CharacterFlags & BatchFlag_NowAiming) != 0, (CharacterFlags & BatchFlag_NowShifting) != 0);
+	}, ParallelFlags);
+}
+
+void UHappyCharacterBatchSubsystem::ApplyCharacters()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HappyCharacterBatchApply);
+
+	for (int32 Index = 0; Index < Characters.Num(); Index++)
+	{
+		if (Flags[Index] & BatchFlag_Skipped) continue;
+
+		AHappyHazardCharacter* Character = Characters[Index].Get();
+
+		Character->AimingPercent = AimingPercents[Index];
+		Character->bShootable = (AimingPercents[Index] >= 0.99f);
+		Character->moveXInput = MoveXInputs[Index];
+		Character->moveYInput = MoveYInputs[Index];
+
+		Character->GetCameraBoom()->TargetArmLength = ArmLengths[Index];
+		Character->GetCameraBoom()->SocketOffset = SocketOffsets[Index];
+		Character->GetCharacterMovement()->MaxWalkSpeed = MoveSpeeds[Index];
+
+		const uint8 CharacterFlags = Flags[Index];
+		if ((CharacterFlags & BatchFlag_Aiming) && (CharacterFlags & BatchFlag_HasController))
+		{
+			Character->SetActorRotation(FRotator(0.f, ControlYaws[Index], 0.f));
+		}
+
+		// the actor tick is off while batched, so the aim change event goes out from here
+		Character->PushAimChangedEvent();
+	}
+}
+
+void UHappyCharacterBatchSubsystem::StartBenchmark(const TArray<int32>& Counts, int32 Frames)
+{
+	if (IsBenchmarking())
+	{
+		UE_LOG(LogHappyCharacterBatch, Warning, TEXT("BenchBatchTick already running"));
+		return;
+	}
+
+	BenchFrames = FMath::Max(Frames, 1);
+	for (int32 Count : Counts)
+	{
+		if (Count > 0)
+		{
+			PendingBenchCounts.Add(Count);
+		}
+	}
+}
+
+void UHappyCharacterBatchSubsystem::TickBenchmark()
+{
+	if (BenchPhase == EBenchPhase::None)
+	{
+		if (PendingBenchCounts.Num() == 0) return;
+
+		const int32 Count = PendingBenchCounts[0];
+		PendingBenchCounts.RemoveAt(0);
+		SpawnBenchCharacters(Count);
+		BeginBenchPhase(EBenchPhase::PerActor);
+		return;
+	}
+
+	// GGameThreadTime is the frame that just ended, the one the phase was switched in is skipped
+	BenchFramesDone++;
+	if (BenchFramesDone >= 2)
+	{
+		BenchGameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+
+	if (BenchFramesDone <= BenchFrames) return;
+
+	const double AverageMs = BenchGameThreadMs / BenchFrames;
+
+	if (BenchPhase == EBenchPhase::PerActor)
+	{
+		BenchPerActorMs = AverageMs;
+		BeginBenchPhase(EBenchPhase::Batched);
+		return;
+	}
+
+	UE_LOG(LogHappyCharacterBatch, Display, TEXT("BenchBatchTick %4d characters: game thread per actor %.3f ms, batched %.3f ms (%+.3f ms/frame over %d frames)"),
+		BenchCharacters.Num(), BenchPerActorMs, AverageMs, AverageMs - BenchPerActorMs, BenchFrames);
+
+	for (const TWeakObjectPtr<AHappyHazardCharacter>& Character : BenchCharacters)
+	{
+		if (!Character.IsValid()) continue;
+
+		UnregisterCharacter(Character.Get());
+		if (AController* BenchController = Character->GetController())
+		{
+			BenchController->Destroy();
+		}
+		Character->Destroy();
+	}
+
+	BenchCharacters.Reset();
+	BenchPhase = EBenchPhase::None;
+}
+
+void UHappyCharacterBatchSubsystem::SpawnBenchCharacters(int32 Count)
+{
+	UWorld* World = GetWorld();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	BenchCharacters.Reserve(Count);
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		FVector Location(Index % 32 * 200.f, Index / 32 * 200.f, 100000.f);
+		if (AHappyHazardCharacter* Character = World->SpawnActor<AHappyHazardCharacter>(AHappyHazardCharacter::StaticClass(), Location, FRotator::ZeroRotator, SpawnParams))
+		{
+			// flying so GetIsAiming() isn't cancelled by falling, and a controller so aim pitch and rotation sync run
+			Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+			Character->SpawnDefaultController();
+			if (AController* BenchController = Character->GetController())
+			{
+				BenchController->SetControlRotation(FRotator(Index % 60 - 30.f, Index * 7.f, 0.f));
+			}
+
+			// measure the full update every frame, whatever fidelity tier the governor is at
+			Character->SetActorTickInterval(0.f);
+
+			BenchCharacters.Add(Character);
+		}
+	}
+}
+
+void UHappyCharacterBatchSubsystem::BeginBenchPhase(EBenchPhase Phase)
+{
+	BenchPhase = Phase;
+	BenchFramesDone = 0;
+	BenchGameThreadMs = 0.0;
+
+	for (int32 Index = 0; Index < BenchCharacters.Num(); Index++)
+	{
+		AHappyHazardCharacter* Character = BenchCharacters[Index].Get();
+		if (!Character) continue;
+
+		// per actor: each character's own tick function runs the logic, batched: only the batch tick does
+		if (Phase == EBenchPhase::Batched)
+		{
+			RegisterCharacter(Character);
+		}
+		else
+		{
+			UnregisterCharacter(Character);
+		}
+
+		// moving, half of them aiming and some sprinting, the same start for both phases
+		Character->bNowAiming = (Index % 2) == 0;
+		Character->bNowShifting = (Index % 3) == 0;
+		Character->AimingPercent = 0.f;
+		Character->moveXInput = 1.f;
+		Character->moveYInput = 0.5f;
+		Character->GetCharacterMovement()->Velocity = FVector(200.f, 0.f, 0.f);
+	}
+}
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Character/HappyHazardCharacter.h"
+#include "HappyHazard.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -10,9 +11,17 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
-#include "UI/PlayerHUD.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 #include "Controller/HappyPlayerController.h"
+#include "Battle/HappyCorpseSubsystem.h"
 #include "Battle/Weapon.h"
+#include "Character/HappyCharacterBatchSubsystem.h"
+#include "Debug/HappyStartupProfiler.h"
+#include "Event/HappyGameplayEventBus.h"
+#include "Item/HappyInteractableItem.h"
+#include "Performance/HappyPerformanceGovernor.h"
+#include "Replay/HappyInputReplaySubsystem.h"
+#include "Replay/HappyKillcamSubsystem.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -21,6 +30,8 @@ DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
 AHappyHazardCharacter::AHappyHazardCharacter()
 {
+	LLM_SCOPE_BYTAG(HappyHazard_Character);
+
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 		
@@ -62,135 +73,220 @@ void AHappyHazardCharacter::Tick(float deltaTime)
 {
 	Super::Tick(deltaTime);
 
-	if (GEngine)
-	{
-		FString text = FString::Printf(TEXT("MovementVector moveXInput %f"), moveXInput);
-		GEngine->AddOnScreenDebugMessage(1, 0.f, FColor::Blue, text);
-	}
+	// disabled while UHappyCharacterBatchSubsystem updates this character
+	TickCharacterLogic(deltaTime);
 
-	if (GEngine)
-	{
-		FString text = FString::Printf(TEXT("MovementVector moveYInput %f"), moveYInput);
-		GEngine->AddOnScreenDebugMessage(2, 0.f, FColor::Red, text);
-	}
+	PushAimChangedEvent();
+}
 
+void AHappyHazardCharacter::TickCharacterLogic(float deltaTime)
+{
 	if (GetCharacterMovement()->Velocity.Length() <= 0)
 	{
 		SetMoveInputLerp(0.f, 0.f);
 	}
 
 
-	AimingLerp(deltaTime);
-	AimingPitchLerp(deltaTime);
+	// built once per tick and shared, it is a copy of a dozen members
+	const FHappyCharacterTuning Tuning = GetTuning();
 
-	SetUIUpdateTick();
+	AimingLerp(deltaTime, Tuning);
 
-	SetMoveSpeed();
+	SetMoveSpeed(Tuning);
 
-	if (GetIsAiming())
+	if (GetIsAiming() && Controller)
 	{
 		FRotator NewRotation = Controller->GetControlRotation();
 		NewRotation.Pitch = 0;
 		SetActorRotation(NewRotation);
 	}
+}
+
+FHappyCharacterTuning AHappyHazardCharacter::GetTuning() const
+{
+	FHappyCharacterTuning Tuning;
+
+	Tuning.DefaultArmLength = DefaultArmLength;
+	Tuning.AimArmLength = AimArmLength;
+	Tuning.AimUpArmLength = AimUpArmLength;
+	Tuning.AimDownArmLength = AimDownArmLength;
 
+	Tuning.DefaultSocketPosition = DefaultSocketPosition;
+	Tuning.AimSocketPosition = AimSocketPosition;
+	Tuning.AimUpSocketPosition = AimUpSocketPosition;
+	Tuning.AimDownSocketPosition = AimDownSocketPosition;
 
+	Tuning.AimMoveSpeed = AimMoveSpeed;
+	Tuning.DefaultMoveSpeed = DefaultMoveSpeed;
+	Tuning.ShiftMoveSpeed = ShiftMoveSpeed;
+
+	return Tuning;
 }
 
-void AHappyHazardCharacter::AimingLerp(float deltaTime)
+void AHappyHazardCharacter::AimingLerp(float deltaTime, const FHappyCharacterTuning& Tuning)
 {
-	if (GetIsAiming())
-	{
-		AimingPercent += deltaTime * 5;
-
-	}
-	else
-	{
-		AimingPercent -= deltaTime * 5;
-	
-	}
+	const bool bAiming = GetIsAiming();
 
-	AimingPercent = FMath::Clamp(AimingPercent, 0.f, 1.f);
+	AimingPercent = HappyCharacterLogic::StepAimingPercent(AimingPercent, bAiming, deltaTime);
 	bShootable = (AimingPercent >= 0.99f);
-	
 
-	float LerpArmLength = FMath::Lerp(DefaultArmLength, AimArmLength, AimingPercent);
-	FVector LerpSocketPosition = FMath::Lerp(DefaultSocketPosition, AimSocketPosition, AimingPercent);
-	//FRotator LerpCameraRotator = FMath::Lerp(DefaultCameraRotation, AimCameraRotation, AimingPercent);
+	// while aiming the arm follows the pitch, otherwise it lerps between default and aim
+	float LerpArmLength = 0.f;
+	FVector LerpSocketPosition = FVector::ZeroVector;
+	HappyCharacterLogic::SolveCameraBoom(Tuning, AimingPercent, bAiming, GetAimPitch(), LerpArmLength, LerpSocketPosition);
 
 	CameraBoom->TargetArmLength = LerpArmLength;
 	CameraBoom->SocketOffset = LerpSocketPosition;
+}
 
-	//FollowCamera->SetRelativeRotation(LerpCameraRotator);
+void AHappyHazardCharacter::BeginPlay()
+{
+	LLM_SCOPE_BYTAG(HappyHazard_Character);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AHappyHazardCharacter::BeginPlay);
+	FHappyStartupPhaseScope StartupPhase(TEXT("CharacterBeginPlay"));
+
+	// Call the base class  
+	Super::BeginPlay();
 
+	Health = MaxHealth;
 
+	if (GetController())
+	{
+		HappyPlayerController = Cast<AHappyPlayerController>(GetController());
+	}
+
+	if (UHappyCharacterBatchSubsystem* BatchSubsystem = GetWorld()->GetSubsystem<UHappyCharacterBatchSubsystem>())
+	{
+		BatchSubsystem->RegisterCharacter(this);
+	}
+
+	// spawned or streamed in after the last fidelity change
+	if (UHappyPerformanceGovernor* Governor = GetWorld()->GetSubsystem<UHappyPerformanceGovernor>())
+	{
+		Governor->ApplyTierToCharacter(this);
+	}
+
+	if (IsPlayerControlled())
+	{
+		FHappyStartupProfiler::Get().NotifyPlayerReady();
+	}
 }
 
-void AHappyHazardCharacter::AimingPitchLerp(float deltaTime)
+void AHappyHazardCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (!GetIsAiming()) return;
+	if (bBatchTicked)
+	{
+		if (UHappyCharacterBatchSubsystem* BatchSubsystem = GetWorld()->GetSubsystem<UHappyCharacterBatchSubsystem>())
+		{
+			BatchSubsystem->UnregisterCharacter(this);
+		}
+		bBatchTicked = false;
+	}
 
-	float Pitch = GetAimPitch();
+	// still here means it was not released for travel
+	if (EquipWeapon)
+	{
+		EquipWeapon->Destroy();
+		EquipWeapon = nullptr;
+	}
 
-	Pitch = Pitch / 90;
+	Super::EndPlay(EndPlayReason);
+}
 
-	if (Pitch >= 0)
-	{
-		float LerpArmLength = FMath::Lerp(AimArmLength, AimUpArmLength, Pitch);
-		CameraBoom->TargetArmLength = LerpArmLength;
+void AHappyHazardCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
 
-		FVector LerpSocketPosition = FMath::Lerp(AimSocketPosition, AimUpSocketPosition, Pitch);
-		CameraBoom->SocketOffset = LerpSocketPosition;
+	// possessed by the local player after begin play, or handed over to AI
+	if (UHappyPerformanceGovernor* Governor = GetWorld()->GetSubsystem<UHappyPerformanceGovernor>())
+	{
+		Governor->ApplyTierToCharacter(this);
+	}
 
+	if (UHappyCharacterBatchSubsystem* BatchSubsystem = GetWorld()->GetSubsystem<UHappyCharacterBatchSubsystem>())
+	{
+		BatchSubsystem->NotifyControllerChanged(this);
 	}
-	else
+}
+
+#if WITH_EDITOR
+void AHappyHazardCharacter::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// tuning tweaked in the details panel during PIE, the batch works from its own copy
+	if (bBatchTicked)
 	{
-		Pitch = FMath::Abs(Pitch);
-		float LerpArmLength = FMath::Lerp(AimArmLength, AimDownArmLength, Pitch);
-		CameraBoom->TargetArmLength = LerpArmLength;
+		if (UHappyCharacterBatchSubsystem* BatchSubsystem = GetWorld()->GetSubsystem<UHappyCharacterBatchSubsystem>())
+		{
+			BatchSubsystem->RefreshTuning(this);
+		}
+	}
+}
+#endif
 
-		FVector LerpSocketPosition = FMath::Lerp(AimSocketPosition, AimDownSocketPosition, Pitch);
-		CameraBoom->SocketOffset = LerpSocketPosition;
+float AHappyHazardCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float AppliedDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	if (bDead || AppliedDamage <= 0.f) return AppliedDamage;
 
+	Health -= AppliedDamage;
+	if (Health <= 0.f)
+	{
+		Die();
 	}
+
+	return AppliedDamage;
 }
 
-void AHappyHazardCharacter::BeginPlay()
+void AHappyHazardCharacter::Die()
 {
-	// Call the base class  
-	Super::BeginPlay();
+	bDead = true;
+	bNowAiming = false;
+	bNowShifting = false;
 
-	if (GetController())
+	SetWeaponEquip(false);
+
+	// a ragdoll has no aim or move speed to update
+	if (bBatchTicked)
 	{
-		HappyPlayerController = Cast<AHappyPlayerController>(GetController());
+		if (UHappyCharacterBatchSubsystem* BatchSubsystem = GetWorld()->GetSubsystem<UHappyCharacterBatchSubsystem>())
+		{
+			BatchSubsystem->UnregisterCharacter(this);
+		}
+		bBatchTicked = false;
+	}
+	SetActorTickEnabled(false);
+
+	// before the corpse detaches the controller, the killcam needs it to tell the player's death apart
+	if (UHappyKillcamSubsystem* Killcam = GetWorld()->GetSubsystem<UHappyKillcamSubsystem>())
+	{
+		Killcam->NotifyCharacterDied(this);
 	}
 
-	if (HappyPlayerController)
+	if (UHappyCorpseSubsystem* CorpseSubsystem = GetWorld()->GetSubsystem<UHappyCorpseSubsystem>())
+	{
+		CorpseSubsystem->AddCorpse(this);
+	}
+	else
 	{
-		PlayerHUD = Cast<APlayerHUD>(HappyPlayerController->GetHUD());
+		DetachFromControllerPendingDestroy();
 	}
 }
 
 void AHappyHazardCharacter::SetWeaponEquip(bool isEquiped)
 {
-	bEquiped = isEquiped;
+	LLM_SCOPE_BYTAG(HappyHazard_Weapon);
 
-	if (EquipWeapon)
-	{
-		EquipWeapon->Destroy();
-		EquipWeapon = nullptr;
-	}
+	bEquiped = isEquiped;
 
-	if (bEquiped)
+	if (!EquipWeapon && bEquiped && PistolClass)
 	{
 		FActorSpawnParameters SpawnParams;
 		SpawnParams.Owner = this;
 		SpawnParams.Instigator = GetInstigator();
 
-		if (PistolClass)
-		{
-			EquipWeapon = GetWorld()->SpawnActor<AWeapon>(PistolClass, SpawnParams);
-		}
+		EquipWeapon = GetWorld()->SpawnActor<AWeapon>(PistolClass, SpawnParams);
 
 		if (EquipWeapon)
 		{
@@ -198,15 +294,69 @@ void AHappyHazardCharacter::SetWeaponEquip(bool isEquiped)
 			EquipWeapon->AttachToComponent(GetMesh(), AttachmentRules, FName("PistolSocket"));
 		}
 	}
+
+	if (EquipWeapon)
+	{
+		EquipWeapon->SetActorHiddenInGame(!bEquiped);
+		EquipWeapon->SetActorEnableCollision(bEquiped);
+	}
+}
+
+void AHappyHazardCharacter::ReleaseCarriedActors(TArray<AActor*>& OutActors)
+{
+	TArray<AActor*> AttachedActors;
+	GetAttachedActors(AttachedActors);
+
+	for (AActor* Actor : AttachedActors)
+	{
+		if (!IsCarriedActor(Actor)) continue;
+
+		Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		Actor->SetOwner(GetController());
+		Actor->SetActorHiddenInGame(true);
+		Actor->SetActorEnableCollision(false);
+		OutActors.Add(Actor);
+	}
+
+	EquipWeapon = nullptr;
 }
 
-void AHappyHazardCharacter::SetUIUpdateTick()
+void AHappyHazardCharacter::AdoptCarriedActor(AActor* Actor)
 {
-	if (PlayerHUD)
+	if (!IsCarriedActor(Actor)) return;
+
+	Actor->SetOwner(this);
+
+	AWeapon* Weapon = Cast<AWeapon>(Actor);
+	if (Weapon && !EquipWeapon)
 	{
-		PlayerHUD->SetAimDisplay(GetIsAiming());
+		EquipWeapon = Weapon;
+		EquipWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), FName("PistolSocket"));
+		EquipWeapon->SetActorHiddenInGame(!bEquiped);
+		EquipWeapon->SetActorEnableCollision(bEquiped);
+		return;
 	}
 
+	// carried but not in hand
+	Actor->AttachToComponent(GetRootComponent(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true));
+}
+
+bool AHappyHazardCharacter::IsCarriedActor(const AActor* Actor)
+{
+	return Actor && (Actor->IsA<AWeapon>() || Actor->IsA<AHappyInteractableItem>());
+}
+
+void AHappyHazardCharacter::PushAimChangedEvent()
+{
+	const bool bAiming = GetIsAiming();
+	if (bAiming == bLastAimingState) return;
+
+	bLastAimingState = bAiming;
+
+	if (UHappyGameplayEventBus* EventBus = GetWorld()->GetSubsystem<UHappyGameplayEventBus>())
+	{
+		EventBus->Push(EHappyEventChannel::Aim, EHappyEventType::AimChanged, this, bAiming ? 1.f : 0.f);
+	}
 }
 
 bool AHappyHazardCharacter::GetIsAiming() const
@@ -288,8 +438,82 @@ void AHappyHazardCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInp
 	}
 }
 
+void AHappyHazardCharacter::ReplayInput(EHappyRecordedAction Action, const FVector2D& AxisValue)
+{
+	switch (Action)
+	{
+	case EHappyRecordedAction::Move:
+		Move(FInputActionValue(AxisValue));
+		break;
+	case EHappyRecordedAction::Look:
+		Look(FInputActionValue(AxisValue));
+		break;
+	case EHappyRecordedAction::AimStart:
+		AimStart(FInputActionValue(true));
+		break;
+	case EHappyRecordedAction::AimEnd:
+		AimEnd(FInputActionValue(false));
+		break;
+	case EHappyRecordedAction::Fire:
+		Fire(FInputActionValue(true));
+		break;
+	case EHappyRecordedAction::ShiftStart:
+		ShiftStart(FInputActionValue(true));
+		break;
+	case EHappyRecordedAction::ShiftEnd:
+		ShiftEnd(FInputActionValue(false));
+		break;
+	default:
+		break;
+	}
+}
+
+void AHappyHazardCharacter::CaptureReplayState(FHappyReplayStartState& OutState) const
+{
+	OutState.Location = GetActorLocation();
+	OutState.Rotation = GetActorRotation();
+	OutState.ControlRotation = GetControlRotation();
+	OutState.Velocity = GetCharacterMovement()->Velocity;
+
+	OutState.bAiming = bNowAiming;
+	OutState.bShifting = bNowShifting;
+	OutState.AimingPercent = AimingPercent;
+	OutState.MoveInput = FVector2f(moveXInput, moveYInput);
+}
+
+void AHappyHazardCharacter::RestoreReplayState(const FHappyReplayStartState& State)
+{
+	TeleportTo(State.Location, State.Rotation);
+	if (Controller)
+	{
+		Controller->SetControlRotation(State.ControlRotation);
+	}
+	GetCharacterMovement()->Velocity = State.Velocity;
+
+	// same side effects as AimStart / AimEnd, without going through the recorder
+	bNowAiming = State.bAiming;
+	GetCharacterMovement()->bOrientRotationToMovement = !bNowAiming;
+	SetWeaponEquip(bNowAiming);
+
+	bNowShifting = State.bShifting;
+	AimingPercent = State.AimingPercent;
+	moveXInput = State.MoveInput.X;
+	moveYInput = State.MoveInput.Y;
+}
+
+void AHappyHazardCharacter::RecordInput(EHappyRecordedAction Action, const FInputActionValue& Value)
+{
+	UHappyInputReplaySubsystem* InputReplay = GetWorld()->GetSubsystem<UHappyInputReplaySubsystem>();
+	if (InputReplay && InputReplay->IsRecording())
+	{
+		InputReplay->RecordAction(Action, Value.Get<FVector2D>());
+	}
+}
+
 void AHappyHazardCharacter::Move(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::Move, Value);
+
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
 
@@ -319,44 +543,19 @@ void AHappyHazardCharacter::Move(const FInputActionValue& Value)
 
 void AHappyHazardCharacter::SetMoveInputLerp(float aimmoveXInput, float aimmoveYInput)
 {
-	if (aimmoveXInput * moveXInput < 0)
-	{
-		moveXInput = FMath::Lerp(moveXInput, aimmoveXInput, 0.03f);
-	}
-	else
-	{
-		moveXInput = FMath::Lerp(moveXInput, aimmoveXInput, 0.1f);
-	}
-
-	if (aimmoveYInput * moveYInput < 0)
-	{
-		moveYInput = FMath::Lerp(moveYInput, aimmoveYInput, 0.03f);
-	}
-	else
-	{
-		moveYInput = FMath::Lerp(moveYInput, aimmoveYInput, 0.1f);
-	}
+	moveXInput = HappyCharacterLogic::StepMoveInput(moveXInput, aimmoveXInput);
+	moveYInput = HappyCharacterLogic::StepMoveInput(moveYInput, aimmoveYInput);
 }
 
-void AHappyHazardCharacter::SetMoveSpeed()
+void AHappyHazardCharacter::SetMoveSpeed(const FHappyCharacterTuning& Tuning)
 {
-	float Speed = DefaultMoveSpeed;
-
-	if (bNowAiming)
-	{
-		Speed = AimMoveSpeed;
-	}
-	else if (bNowShifting)
-	{
-		Speed = ShiftMoveSpeed;
-	}
-
-	GetCharacterMovement()->MaxWalkSpeed = Speed;
-
+	GetCharacterMovement()->MaxWalkSpeed = HappyCharacterLogic::SolveMoveSpeed(Tuning, bNowAiming, bNowShifting);
 }
 
 void AHappyHazardCharacter::Look(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::Look, Value);
+
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
 
@@ -379,6 +578,8 @@ void AHappyHazardCharacter::Look(const FInputActionValue& Value)
 
 void AHappyHazardCharacter::AimStart(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::AimStart, Value);
+
 	bNowAiming = true;
 
 	GetCharacterMovement()->bOrientRotationToMovement = false; 
@@ -388,6 +589,8 @@ void AHappyHazardCharacter::AimStart(const FInputActionValue& Value)
 
 void AHappyHazardCharacter::AimEnd(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::AimEnd, Value);
+
 	bNowAiming = false;
 
 	GetCharacterMovement()->bOrientRotationToMovement = true;
@@ -399,18 +602,30 @@ void AHappyHazardCharacter::AimEnd(const FInputActionValue& Value)
 
 void AHappyHazardCharacter::Fire(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::Fire, Value);
+
 	if (!bShootable) return;
 
  	UE_LOG(LogTemp, Warning, TEXT("Fire"));
+
+	if (UHappyGameplayEventBus* EventBus = GetWorld()->GetSubsystem<UHappyGameplayEventBus>())
+	{
+		EventBus->Push(EHappyEventChannel::Weapon, EHappyEventType::Fire, EquipWeapon ? static_cast<AActor*>(EquipWeapon.Get()) : this);
+		EventBus->Push(EHappyEventChannel::Noise, EHappyEventType::Noise, this, 1.f);
+	}
 }
 
 
 void AHappyHazardCharacter::ShiftStart(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::ShiftStart, Value);
+
 	bNowShifting = true;
 }
 
 void AHappyHazardCharacter::ShiftEnd(const FInputActionValue& Value)
 {
+	RecordInput(EHappyRecordedAction::ShiftEnd, Value);
+
 	bNowShifting = false;
 }
@@ -2,4 +2,22 @@
 
 
 #include "Controller/HappyPlayerController.h"
+#include "Replay/HappyInputReplaySubsystem.h"
 
+void AHappyPlayerController::PlayerTick(float DeltaTime)
+{
+	UHappyInputReplaySubsystem* InputReplay = GetWorld()->GetSubsystem<UHappyInputReplaySubsystem>();
+
+	// replayed input goes through the pawn's handlers right where live input would
+	if (InputReplay)
+	{
+		InputReplay->PreControllerTick(this, DeltaTime);
+	}
+
+	Super::PlayerTick(DeltaTime);
+
+	if (InputReplay)
+	{
+		InputReplay->PostControllerTick(this, DeltaTime);
+	}
+}
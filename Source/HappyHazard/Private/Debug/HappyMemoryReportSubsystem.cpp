@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Debug/HappyMemoryReportSubsystem.h"
+#include "HappyHazard.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CommandLine.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyMemory, Log, All);
+
+static FAutoConsoleCommandWithWorld CmdHappyMemReport(
+	TEXT("HappyHazard.MemReport"),
+	TEXT("Log memory held by each HappyHazard LLM tag against its budget (needs -llm)."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyMemoryReportSubsystem* MemoryReport = World ? World->GetSubsystem<UHappyMemoryReportSubsystem>() : nullptr)
+		{
+			MemoryReport->DumpReport();
+		}
+	}));
+
+bool UHappyMemoryReportSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyMemoryReportSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHappyMemoryReportSubsystem, STATGROUP_HappyHazard);
+}
+
+void UHappyMemoryReportSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FParse::Value(FCommandLine::Get(), TEXT("HappyMemReport="), ReportDelay);
+}
+
+void UHappyMemoryReportSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ReportDelay -= DeltaTime;
+	if (ReportDelay >= 0.f) return;
+
+	const int32 NumOverBudget = DumpReport();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("HappyMemReportExit")))
+	{
+		// non zero exit code so a build step can fail on budget
+		FPlatformMisc::RequestExitWithStatus(false, NumOverBudget > 0 ? 1 : 0);
+	}
+}
+
+int32 UHappyMemoryReportSubsystem::DumpReport() const
+{
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	UE_LOG(LogHappyMemory, Display, TEXT("HappyHazard memory report, process used %.1f MB"), MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	if (!Tracker.IsEnabled())
+	{
+		UE_LOG(LogHappyMemory, Warning, TEXT("LLM is off, run with -llm to get per subsystem numbers"));
+		return 0;
+	}
+
+	// amounts are published once per frame, bring them up to date first
+	Tracker.UpdateStatsPerFrame();
+
+	const FName Tags[] =
+	{
+		LLM_TAG_NAME(HappyHazard),
+		LLM_TAG_NAME(HappyHazard_Character),
+		LLM_TAG_NAME(HappyHazard_Weapon),
+		LLM_TAG_NAME(HappyHazard_Item),
+		LLM_TAG_NAME(HappyHazard_UI),
+		LLM_TAG_NAME(HappyHazard_Corpse),
+		LLM_TAG_NAME(HappyHazard_Audio),
+		LLM_TAG_NAME(HappyHazard_Events),
+		LLM_TAG_NAME(HappyHazard_Replay),
+	};
+
+	int32 NumOverBudget = 0;
+
+	for (const FName& Tag : Tags)
+	{
+		const double AmountMB = Tracker.GetTagAmountForTracker(ELLMTracker::Default, Tag, ELLMTagSet::None) / (1024.0 * 1024.0);
+
+		const FHappyMemoryBudget* Budget = Budgets.FindByPredicate([&Tag](const FHappyMemoryBudget& Entry) { return Entry.Tag == Tag; });
+		if (Budget && Budget->BudgetMB > 0.f && AmountMB > Budget->BudgetMB)
+		{
+			NumOverBudget++;
+			UE_LOG(LogHappyMemory, Warning, TEXT("  %-24s %8.2f MB / %8.2f MB  OVER BUDGET"), *Tag.ToString(), AmountMB, Budget->BudgetMB);
+		}
+		else if (Budget && Budget->BudgetMB > 0.f)
+		{
+			UE_LOG(LogHappyMemory, Display, TEXT("  %-24s %8.2f MB / %8.2f MB"), *Tag.ToString(), AmountMB, Budget->BudgetMB);
+		}
+		else
+		{
+			UE_LOG(LogHappyMemory, Display, TEXT("  %-24s %8.2f MB   (no budget)"), *Tag.ToString(), AmountMB);
+		}
+	}
+
+	return NumOverBudget;
+#else
+	UE_LOG(LogHappyMemory, Warning, TEXT("LLM is compiled out of this build"));
+	return 0;
+#endif
+}
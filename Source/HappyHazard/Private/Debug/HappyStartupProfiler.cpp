@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Debug/HappyStartupProfiler.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyStartup, Log, All);
+
+FHappyStartupProfiler& FHappyStartupProfiler::Get()
+{
+	// first use can be a class default object constructor, before the module has started
+	static FHappyStartupProfiler Profiler;
+	return Profiler;
+}
+
+FHappyStartupProfiler::FHappyStartupProfiler()
+{
+	bEnabled = FParse::Param(FCommandLine::Get(), TEXT("HappyStartupProfile"));
+	if (!bEnabled) return;
+
+	EndLoadPackageHandle = FCoreUObjectDelegates::OnEndLoadPackage.AddRaw(this, &FHappyStartupProfiler::HandleEndLoadPackage);
+	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FHappyStartupProfiler::HandlePostEngineInit);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FHappyStartupProfiler::HandleEndFrame);
+}
+
+void FHappyStartupProfiler::NotifyModuleStartup()
+{
+	if (!IsRecording()) return;
+
+	ModuleStartup = TakeSnapshot();
+
+	// everything loaded before us, the counter only sees packages from here on
+	PackagesBeforeStartup = 0;
+	for (TObjectIterator<UPackage> It; It; ++It)
+	{
+		PackagesBeforeStartup++;
+	}
+
+	FSnapshot ProcessStart;
+	ProcessStart.Time = GStartTime;
+	ProcessStart.PackagesLoaded = -PackagesBeforeStartup;
+
+	RecordPhase(TEXT("EnginePreInit"), ProcessStart);
+}
+
+void FHappyStartupProfiler::NotifyPlayerReady()
+{
+	if (!IsRecording() || bPlayerReady) return;
+
+	bPlayerReady = true;
+	PlayerReady = TakeSnapshot();
+}
+
+FHappyStartupProfiler::FSnapshot FHappyStartupProfiler::TakeSnapshot() const
+{
+	FSnapshot Snapshot;
+	Snapshot.Time = FPlatformTime::Seconds();
+	Snapshot.PackagesLoaded = PackagesLoaded.load(std::memory_order_relaxed);
+	Snapshot.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	Snapshot.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	return Snapshot;
+}
+
+void FHappyStartupProfiler::RecordPhase(const TCHAR* Name, const FSnapshot& Start)
+{
+	if (!IsRecording()) return;
+
+	const FSnapshot End = TakeSnapshot();
+
+	// the start stays the first occurrence's, the rest is summed over every run
+	FPhase* Phase = Phases.FindByPredicate([Name](const FPhase& Existing) { return Existing.Name == Name; });
+	if (!Phase)
+	{
+		Phase = &Phases.AddDefaulted_GetRef();
+		Phase->Name = Name;
+		Phase->StartSeconds = Start.Time - GStartTime;
+	}
+
+	Phase->DurationMs += (End.Time - Start.Time) * 1000.0;
+	Phase->PackagesLoaded += End.PackagesLoaded - Start.PackagesLoaded;
+	Phase->ObjectsCreated += End.NumObjects - Start.NumObjects;
+	Phase->MemoryDeltaBytes += static_cast<int64>(End.UsedPhysical) - static_cast<int64>(Start.UsedPhysical);
+	Phase->Count++;
+}
+
+void FHappyStartupProfiler::HandleEndLoadPackage(const FEndLoadPackageContext& Context)
+{
+	PackagesLoaded.fetch_add(Context.LoadedPackages.Num(), std::memory_order_relaxed);
+}
+
+void FHappyStartupProfiler::HandlePostEngineInit()
+{
+	RecordPhase(TEXT("EngineInit"), ModuleStartup);
+}
+
+void FHappyStartupProfiler::HandleEndFrame()
+{
+	if (!bPlayerReady || bFinished) return;
+
+	RecordPhase(TEXT("FirstFrame"), PlayerReady);
+
+	FSnapshot ProcessStart;
+	ProcessStart.Time = GStartTime;
+	ProcessStart.PackagesLoaded = -PackagesBeforeStartup;
+	RecordPhase(TEXT("Total"), ProcessStart);
+
+	Finish();
+}
+
+void FHappyStartupProfiler::Finish()
+{
+	bFinished = true;
+
+	FCoreUObjectDelegates::OnEndLoadPackage.Remove(EndLoadPackageHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+
+	WriteReport();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("HappyStartupProfileExit")))
+	{
+		FPlatformMisc::RequestExitWithStatus(false, 0);
+	}
+}
+
+void FHappyStartupProfiler::WriteReport() const
+{
+	UE_LOG(LogHappyStartup, Display, TEXT("Startup breakdown (start s, duration ms, packages, objects, memory MB, count)"));
+
+	for (const FPhase& Phase : Phases)
+	{
+		UE_LOG(LogHappyStartup, Display, TEXT("  %-28s %8.3f %10.2f %8d %8d %8.1f %6d"),
+			*Phase.Name, Phase.StartSeconds, Phase.DurationMs, Phase.PackagesLoaded, Phase.ObjectsCreated, Phase.MemoryDeltaBytes / (1024.0 * 1024.0), Phase.Count);
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Project"), FString(FApp::GetProjectName()));
+	Writer->WriteValue(TEXT("BuildVersion"), FString(FApp::GetBuildVersion()));
+	Writer->WriteValue(TEXT("BuildConfiguration"), FString(LexToString(FApp::GetBuildConfiguration())));
+	Writer->WriteValue(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+	Writer->WriteValue(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+	Writer->WriteValue(TEXT("CommandLine"), FString(FCommandLine::Get()));
+
+	Writer->WriteArrayStart(TEXT("Phases"));
+	for (const FPhase& Phase : Phases)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Name"), Phase.Name);
+		Writer->WriteValue(TEXT("StartSeconds"), Phase.StartSeconds);
+		Writer->WriteValue(TEXT("DurationMs"), Phase.DurationMs);
+		Writer->WriteValue(TEXT("PackagesLoaded"), Phase.PackagesLoaded);
+		Writer->WriteValue(TEXT("ObjectsCreated"), Phase.ObjectsCreated);
+		Writer->WriteValue(TEXT("MemoryDeltaBytes"), Phase.MemoryDeltaBytes);
+		Writer->WriteValue(TEXT("Count"), Phase.Count);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	const FString Path = FPaths::ProfilingDir() / TEXT("HappyStartup") / FString::Printf(TEXT("Startup-%s.json"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogHappyStartup, Display, TEXT("Startup breakdown written to %s"), *FPaths::ConvertRelativePathToFull(Path));
+	}
+	else
+	{
+		UE_LOG(LogHappyStartup, Error, TEXT("Could not write %s"), *Path);
+	}
+}
+
+FHappyStartupPhaseScope::FHappyStartupPhaseScope(const TCHAR* InName)
+	: Name(InName)
+	, bRecording(FHappyStartupProfiler::Get().IsRecording())
+{
+	if (bRecording)
+	{
+		Start = FHappyStartupProfiler::Get().TakeSnapshot();
+	}
+}
+
+FHappyStartupPhaseScope::~FHappyStartupPhaseScope()
+{
+	if (bRecording)
+	{
+		FHappyStartupProfiler::Get().RecordPhase(Name, Start);
+	}
+}
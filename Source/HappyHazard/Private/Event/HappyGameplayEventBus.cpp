@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Event/HappyGameplayEventBus.h"
+#include "HappyHazard.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Event Bus Drain"), STAT_HappyEventBusDrain, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Events"), STAT_HappyWeaponEvents, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Aim Events"), STAT_HappyAimEvents, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickup Events"), STAT_HappyPickupEvents, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Noise Events"), STAT_HappyNoiseEvents, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyEventBus, Log, All);
+
+static FAutoConsoleCommandWithWorld CmdHappyEventBusStats(
+	TEXT("HappyHazard.EventBus.Stats"),
+	TEXT("Log per channel totals and peak batch sizes of the gameplay event bus."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyGameplayEventBus* EventBus = World ? World->GetSubsystem<UHappyGameplayEventBus>() : nullptr)
+		{
+			EventBus->DumpStats();
+		}
+	}));
+
+static const TCHAR* GetChannelName(int32 Channel)
+{
+	switch (static_cast<EHappyEventChannel>(Channel))
+	{
+	case EHappyEventChannel::Weapon: return TEXT("Weapon");
+	case EHappyEventChannel::Aim: return TEXT("Aim");
+	case EHappyEventChannel::Pickup: return TEXT("Pickup");
+	case EHappyEventChannel::Noise: return TEXT("Noise");
+	default: return TEXT("Unknown");
+	}
+}
+
+bool UHappyGameplayEventBus::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyGameplayEventBus::GetStatId() const
+{
+	return GET_STATID(STAT_HappyEventBusDrain);
+}
+
+void UHappyGameplayEventBus::Push(const FHappyGameplayEvent& Event)
+{
+	LLM_SCOPE_BYTAG(HappyHazard_Events);
+
+	PushedCounts[static_cast<int32>(Event.Channel)].fetch_add(1, std::memory_order_relaxed);
+	PendingEvents.Enqueue(Event);
+}
+
+void UHappyGameplayEventBus::Push(EHappyEventChannel Channel, EHappyEventType Type, AActor* Source, float Value)
+{
+	FHappyGameplayEvent Event;
+	Event.Channel = Channel;
+	Event.Type = Type;
+	Event.Source = Source;
+	Event.Value = Value;
+
+	if (Source)
+	{
+		Event.Location = FVector3f(Source->GetActorLocation());
+	}
+
+	Push(Event);
+}
+
+FOnHappyGameplayEvents& UHappyGameplayEventBus::OnEvents(EHappyEventChannel Channel)
+{
+	check(IsInGameThread());
+	return ChannelListeners[static_cast<int32>(Channel)];
+}
+
+void UHappyGameplayEventBus::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	LLM_SCOPE_BYTAG(HappyHazard_Events);
+
+	FHappyGameplayEvent Event;
+	while (PendingEvents.Dequeue(Event))
+	{
+		ChannelBatches[static_cast<int32>(Event.Channel)].Add(Event);
+	}
+
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		TArray<FHappyGameplayEvent>& Batch = ChannelBatches[Channel];
+		if (Batch.Num() == 0) continue;
+
+		DrainedTotals[Channel] += Batch.Num();
+		PeakBatchSizes[Channel] = FMath::Max(PeakBatchSizes[Channel], Batch.Num());
+
+		ChannelListeners[Channel].Broadcast(Batch);
+
+		// keep the allocation for next frame
+		Batch.Reset();
+	}
+
+	// swapped out before SET_DWORD_STAT so the counters still reset when stats are compiled out
+	uint32 PushedThisFrame[NumChannels];
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		PushedThisFrame[Channel] = PushedCounts[Channel].exchange(0, std::memory_order_relaxed);
+	}
+
+	SET_DWORD_STAT(STAT_HappyWeaponEvents, PushedThisFrame[static_cast<int32>(EHappyEventChannel::Weapon)]);
+	SET_DWORD_STAT(STAT_HappyAimEvents, PushedThisFrame[static_cast<int32>(EHappyEventChannel::Aim)]);
+	SET_DWORD_STAT(STAT_HappyPickupEvents, PushedThisFrame[static_cast<int32>(EHappyEventChannel::Pickup)]);
+	SET_DWORD_STAT(STAT_HappyNoiseEvents, PushedThisFrame[static_cast<int32>(EHappyEventChannel::Noise)]);
+}
+
+void UHappyGameplayEventBus::DumpStats() const
+{
+	const double WorldTime = FMath::Max(GetWorld()->GetTimeSeconds(), 0.001);
+
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		UE_LOG(LogHappyEventBus, Display, TEXT("%-8s drained %8llu (%.1f/s), peak batch %d, listeners %s"),
+			GetChannelName(Channel), DrainedTotals[Channel], DrainedTotals[Channel] / WorldTime, PeakBatchSizes[Channel],
+			ChannelListeners[Channel].IsBound() ? TEXT("yes") : TEXT("no"));
+	}
+}
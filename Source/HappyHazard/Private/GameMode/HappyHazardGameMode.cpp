@@ -2,14 +2,93 @@
 
 #include "GameMode/HappyHazardGameMode.h"
 #include "Character/HappyHazardCharacter.h"
+#include "Debug/HappyStartupProfiler.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/PlayerController.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 #include "UObject/ConstructorHelpers.h"
+#include "World/HappyTravelSubsystem.h"
 
 AHappyHazardGameMode::AHappyHazardGameMode()
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(AHappyHazardGameMode::AHappyHazardGameMode);
+	FHappyStartupPhaseScope StartupPhase(TEXT("GameModeConstructor"));
+
 	// set default pawn class to our Blueprinted character
 	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter"));
 	if (PlayerPawnBPClass.Class != NULL)
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	bUseSeamlessTravel = true;
+}
+
+void AHappyHazardGameMode::GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList)
+{
+	Super::GetSeamlessTravelActorList(bToTransition, ActorList);
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (!PlayerController) continue;
+
+		// pawns don't travel, so the carried actors are parked on the controller for the trip
+		if (AHappyHazardCharacter* Character = Cast<AHappyHazardCharacter>(PlayerController->GetPawn()))
+		{
+			TArray<AActor*> Released;
+			Character->ReleaseCarriedActors(Released);
+		}
+
+		for (AActor* Child : PlayerController->Children)
+		{
+			if (AHappyHazardCharacter::IsCarriedActor(Child))
+			{
+				ActorList.AddUnique(Child);
+			}
+		}
+	}
+}
+
+void AHappyHazardGameMode::HandleSeamlessTravelPlayer(AController*& C)
+{
+	// the controller may be replaced below, so collect what it is holding first
+	TArray<AActor*> CarriedActors;
+	if (C)
+	{
+		for (AActor* Child : C->Children)
+		{
+			if (AHappyHazardCharacter::IsCarriedActor(Child))
+			{
+				CarriedActors.Add(Child);
+			}
+		}
+	}
+
+	Super::HandleSeamlessTravelPlayer(C);
+
+	AHappyHazardCharacter* Character = C ? Cast<AHappyHazardCharacter>(C->GetPawn()) : nullptr;
+
+	for (AActor* Actor : CarriedActors)
+	{
+		if (Character)
+		{
+			Character->AdoptCarriedActor(Actor);
+		}
+		else
+		{
+			Actor->Destroy();
+		}
+	}
+}
+
+void AHappyHazardGameMode::PostSeamlessTravel()
+{
+	Super::PostSeamlessTravel();
+
+	// players have been restarted, the new map is playable from here
+	if (UHappyTravelSubsystem* TravelSubsystem = GetGameInstance()->GetSubsystem<UHappyTravelSubsystem>())
+	{
+		TravelSubsystem->NotifyTravelFinished(GetWorld());
+	}
 }
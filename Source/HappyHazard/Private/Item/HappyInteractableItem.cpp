@@ -2,10 +2,14 @@
 
 
 #include "Item/HappyInteractableItem.h"
+#include "HappyHazard.h"
+#include "Event/HappyGameplayEventBus.h"
 
 // Sets default values
 AHappyInteractableItem::AHappyInteractableItem()
 {
+	LLM_SCOPE_BYTAG(HappyHazard_Item);
+
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -25,3 +29,15 @@ void AHappyInteractableItem::Tick(float DeltaTime)
 
 }
 
+void AHappyInteractableItem::NotifyPickedUp(AActor* Picker)
+{
+	if (UHappyGameplayEventBus* EventBus = GetWorld()->GetSubsystem<UHappyGameplayEventBus>())
+	{
+		FHappyGameplayEvent Event;
+		Event.Channel = EHappyEventChannel::Pickup;
+		Event.Type = EHappyEventType::PickedUp;
+		Event.Source = Picker;
+		Event.Location = FVector3f(GetActorLocation());
+		EventBus->Push(Event);
+	}
+}
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Performance/HappyPerformanceGovernor.h"
+#include "HappyHazard.h"
+#include "Audio/HappyAudioSubsystem.h"
+#include "Battle/HappyCorpseSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "RenderCore.h"
+
+DECLARE_CYCLE_STAT(TEXT("Governor Tick"), STAT_HappyGovernorTick, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Level"), STAT_HappyGovernorLevel, STATGROUP_HappyHazard);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Avg Frame (ms)"), STAT_HappyGovernorFrameMs, STATGROUP_HappyHazard);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Avg Game Thread (ms)"), STAT_HappyGovernorGameThreadMs, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyGovernor, Log, All);
+
+static TAutoConsoleVariable<bool> CVarHappyGovernorEnable(
+	TEXT("HappyHazard.Governor.Enable"),
+	true,
+	TEXT("Let the performance governor change gameplay fidelity."));
+
+static TAutoConsoleVariable<float> CVarHappyGovernorInjectLoadMs(
+	TEXT("HappyHazard.Governor.InjectLoadMs"),
+	0.f,
+	TEXT("Busy wait this many ms on the game thread every frame, to test the governor."));
+
+static FAutoConsoleCommandWithWorld CmdHappyGovernorStatus(
+	TEXT("HappyHazard.Governor.Status"),
+	TEXT("Log the governor's level, averages and active knobs."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyPerformanceGovernor* Governor = World ? World->GetSubsystem<UHappyPerformanceGovernor>() : nullptr)
+		{
+			Governor->DumpStatus();
+		}
+	}));
+
+bool UHappyPerformanceGovernor::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyPerformanceGovernor::GetStatId() const
+{
+	return GET_STATID(STAT_HappyGovernorTick);
+}
+
+void UHappyPerformanceGovernor::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UHappyCorpseSubsystem>();
+	Collection.InitializeDependency<UHappyAudioSubsystem>();
+
+	if (Tiers.Num() == 0)
+	{
+		Tiers.AddDefaulted();
+	}
+
+	SampleWindow = FMath::Max(SampleWindow, 1);
+	FrameSamples.SetNumZeroed(SampleWindow);
+	GameThreadSamples.SetNumZeroed(SampleWindow);
+}
+
+void UHappyPerformanceGovernor::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	ApplyTier();
+}
+
+void UHappyPerformanceGovernor::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const float InjectLoadMs = CVarHappyGovernorInjectLoadMs.GetValueOnGameThread();
+	if (InjectLoadMs > 0.f)
+	{
+		const double EndTime = FPlatformTime::Seconds() + InjectLoadMs / 1000.0;
+		while (FPlatformTime::Seconds() < EndTime)
+		{
+			FPlatformProcess::YieldThread();
+		}
+	}
+
+	// DeltaTime is dilated and, under a fixed timestep (input replay, benchmarks), made up,
+	// so the frame cost is the wall time between two governor ticks
+	const double Now = FPlatformTime::Seconds();
+	const float FrameSeconds = LastTickTime > 0.0 ? static_cast<float>(Now - LastTickTime) : 0.f;
+	LastTickTime = Now;
+
+	// a gap over a second is the game being paused or loading, not frame cost
+	if (FrameSeconds <= 0.f || FrameSeconds > 1.f || FApp::UseFixedTimeStep()) return;
+
+	AddSample(FrameSeconds * 1000.f, FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	SET_DWORD_STAT(STAT_HappyGovernorLevel, Level);
+	SET_FLOAT_STAT(STAT_HappyGovernorFrameMs, AverageFrameMs);
+	SET_FLOAT_STAT(STAT_HappyGovernorGameThreadMs, AverageGameThreadMs);
+
+	if (!CVarHappyGovernorEnable.GetValueOnGameThread()) return;
+
+	const float Pressure = FMath::Max(AverageFrameMs, AverageGameThreadMs) / TargetFrameMs;
+
+	if (Pressure > 1.f + DegradeThreshold)
+	{
+		OverTime += FrameSeconds;
+		UnderTime = 0.f;
+	}
+	else if (Pressure < 1.f - RestoreThreshold)
+	{
+		UnderTime += FrameSeconds;
+		OverTime = 0.f;
+	}
+	else
+	{
+		OverTime = 0.f;
+		UnderTime = 0.f;
+	}
+
+	CooldownLeft -= FrameSeconds;
+	if (CooldownLeft > 0.f) return;
+
+	if (OverTime >= DegradeHoldSeconds && Level < Tiers.Num() - 1)
+	{
+		SetLevel(Level + 1, TEXT("over target"));
+	}
+	else if (UnderTime >= RestoreHoldSeconds && Level > 0)
+	{
+		SetLevel(Level - 1, TEXT("under target"));
+	}
+}
+
+void UHappyPerformanceGovernor::AddSample(float FrameMs, float GameThreadMs)
+{
+	FrameSum += FrameMs - FrameSamples[NextSample];
+	GameThreadSum += GameThreadMs - GameThreadSamples[NextSample];
+
+	FrameSamples[NextSample] = FrameMs;
+	GameThreadSamples[NextSample] = GameThreadMs;
+	NextSample = (NextSample + 1) % SampleWindow;
+
+	AverageFrameMs = FrameSum / SampleWindow;
+	AverageGameThreadMs = GameThreadSum / SampleWindow;
+}
+
+void UHappyPerformanceGovernor::SetLevel(int32 NewLevel, const TCHAR* Reason)
+{
+	UE_LOG(LogHappyGovernor, Log, TEXT("Fidelity level %d -> %d (%s: frame %.2f ms, game thread %.2f ms, target %.2f ms)"),
+		Level, NewLevel, Reason, AverageFrameMs, AverageGameThreadMs, TargetFrameMs);
+
+	Level = NewLevel;
+	OverTime = 0.f;
+	UnderTime = 0.f;
+	CooldownLeft = CooldownSeconds;
+
+	ApplyTier();
+
+	OnFidelityChanged.Broadcast(Level);
+}
+
+void UHappyPerformanceGovernor::ApplyTier()
+{
+	const FHappyFidelityTier& Tier = GetTier();
+
+	if (UHappyCorpseSubsystem* CorpseSubsystem = GetWorld()->GetSubsystem<UHappyCorpseSubsystem>())
+	{
+		CorpseSubsystem->SetBudget(Tier.MaxSimulatingCorpses, Tier.MaxLiveCorpses);
+	}
+
+	if (UHappyAudioSubsystem* AudioSubsystem = GetWorld()->GetSubsystem<UHappyAudioSubsystem>())
+	{
+		AudioSubsystem->SetMaxPoolSize(Tier.MaxAudioPoolSize);
+	}
+
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		ApplyTierToCharacter(*It);
+	}
+}
+
+void UHappyPerformanceGovernor::ApplyTierToCharacter(ACharacter* Character) const
+{
+	if (!Character) return;
+
+	// the local player always stays at full rate
+	const bool bLocalPlayer = Character->IsLocallyControlled() && Character->IsPlayerControlled();
+	const FHappyFidelityTier& Tier = GetTier();
+
+	Character->SetActorTickInterval(bLocalPlayer ? 0.f : Tier.EnemyTickInterval);
+	Character->GetMesh()->SetComponentTickInterval(bLocalPlayer ? 0.f : Tier.EnemyAnimTickInterval);
+}
+
+void UHappyPerformanceGovernor::DumpStatus() const
+{
+	const FHappyFidelityTier& Tier = GetTier();
+
+	UE_LOG(LogHappyGovernor, Display, TEXT("Level %d/%d, frame %.2f ms, game thread %.2f ms, target %.2f ms, cooldown %.1f s"),
+		Level, Tiers.Num() - 1, AverageFrameMs, AverageGameThreadMs, TargetFrameMs, FMath::Max(CooldownLeft, 0.f));
+	UE_LOG(LogHappyGovernor, Display, TEXT("  enemy tick %.3f s, enemy anim tick %.3f s, perception %d, audio pool %d, corpses %d / %d"),
+		Tier.EnemyTickInterval, Tier.EnemyAnimTickInterval, Tier.PerceptionBudget, Tier.MaxAudioPoolSize, Tier.MaxSimulatingCorpses, Tier.MaxLiveCorpses);
+}
@@ -0,0 +1,367 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Replay/HappyInputReplaySubsystem.h"
+#include "HappyHazard.h"
+#include "Character/HappyHazardCharacter.h"
+#include "Controller/HappyPlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyInputReplay, Log, All);
+
+namespace HappyInputReplay
+{
+	static constexpr uint32 FileMagic = 0x52494848; // "HHIR"
+	static constexpr uint32 FileVersion = 2;
+
+	// DeltaTime + ActionMask, the smallest a serialized FHappyInputFrame can be
+	static constexpr int64 MinFrameBytes = sizeof(float) + sizeof(uint8);
+
+	static FString MakeDefaultPath()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("InputRecordings") / FString::Printf(TEXT("Session_%s.hhinput"), *FDateTime::Now().ToString());
+	}
+
+	static AHappyPlayerController* GetFirstController(UWorld* World)
+	{
+		return World ? Cast<AHappyPlayerController>(World->GetFirstPlayerController()) : nullptr;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHappyInputRecord(
+	TEXT("HappyHazard.Input.Record"),
+	TEXT("Start recording the local player's input. Usage: HappyHazard.Input.Record [File]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UHappyInputReplaySubsystem* InputReplay = World ? World->GetSubsystem<UHappyInputReplaySubsystem>() : nullptr)
+		{
+			InputReplay->StartRecording(HappyInputReplay::GetFirstController(World), Args.Num() > 0 ? Args[0] : HappyInputReplay::MakeDefaultPath());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdHappyInputStopRecord(
+	TEXT("HappyHazard.Input.StopRecord"),
+	TEXT("Stop recording and write the input file."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyInputReplaySubsystem* InputReplay = World ? World->GetSubsystem<UHappyInputReplaySubsystem>() : nullptr)
+		{
+			InputReplay->StopRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHappyInputReplay(
+	TEXT("HappyHazard.Input.Replay"),
+	TEXT("Play a recorded input file back on the local player. Usage: HappyHazard.Input.Replay <File>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UHappyInputReplaySubsystem* InputReplay = World ? World->GetSubsystem<UHappyInputReplaySubsystem>() : nullptr;
+		if (InputReplay && Args.Num() > 0)
+		{
+			InputReplay->StartReplay(HappyInputReplay::GetFirstController(World), Args[0]);
+		}
+	}));
+
+FArchive& operator<<(FArchive& Ar, FHappyInputFrame& Frame)
+{
+	Ar << Frame.DeltaTime;
+	Ar << Frame.ActionMask;
+
+	if (Frame.HasAction(EHappyRecordedAction::Move))
+	{
+		Ar << Frame.Move;
+	}
+
+	if (Frame.HasAction(EHappyRecordedAction::Look))
+	{
+		Ar << Frame.Look;
+	}
+
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FHappyReplayStartState& State)
+{
+	Ar << State.Location << State.Rotation << State.ControlRotation << State.Velocity;
+	Ar << State.bAiming << State.bShifting << State.AimingPercent << State.MoveInput;
+	return Ar;
+}
+
+bool UHappyInputReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHappyInputReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+	StopReplay();
+
+	Super::Deinitialize();
+}
+
+bool UHappyInputReplaySubsystem::StartRecording(AHappyPlayerController* Controller, const FString& FilePath)
+{
+	AHappyHazardCharacter* Character = Controller ? Cast<AHappyHazardCharacter>(Controller->GetPawn()) : nullptr;
+	if (!Character || IsRecording() || IsReplaying()) return false;
+
+	LLM_SCOPE_BYTAG(HappyHazard_Replay);
+
+	RecordController = Controller;
+	RecordFilePath = FilePath;
+	bRecording = true;
+
+	// the start state is captured by the next PreControllerTick, the same point replay restores it at
+	bRecordStartPending = true;
+
+	Frames.Reset();
+	PendingFrame = FHappyInputFrame();
+
+	UE_LOG(LogHappyInputReplay, Display, TEXT("Recording input to %s"), *RecordFilePath);
+	return true;
+}
+
+void UHappyInputReplaySubsystem::StopRecording()
+{
+	if (!IsRecording()) return;
+
+	bRecording = false;
+	bRecordStartPending = false;
+	RecordController.Reset();
+
+	if (SaveRecording())
+	{
+		UE_LOG(LogHappyInputReplay, Display, TEXT("Saved %d input frames to %s"), Frames.Num(), *RecordFilePath);
+	}
+	else
+	{
+		UE_LOG(LogHappyInputReplay, Error, TEXT("Failed to save input recording to %s"), *RecordFilePath);
+	}
+
+	Frames.Reset();
+}
+
+bool UHappyInputReplaySubsystem::StartReplay(AHappyPlayerController* Controller, const FString& FilePath)
+{
+	AHappyHazardCharacter* Character = Controller ? Cast<AHappyHazardCharacter>(Controller->GetPawn()) : nullptr;
+	if (!Character || IsRecording() || IsReplaying()) return false;
+
+	if (!LoadRecording(FilePath) || Frames.Num() == 0)
+	{
+		UE_LOG(LogHappyInputReplay, Error, TEXT("Failed to load input recording %s"), *FilePath);
+		return false;
+	}
+
+	ReplayController = Controller;
+
+	// live input would fight the recording
+	Character->DisableInput(Controller);
+
+	// every engine frame from here on advances by exactly the recorded delta
+	bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Frames[0].DeltaTime);
+
+	// this frame's delta is already taken, the start state and frame 0 go in together on the next one,
+	// which runs at Frames[0].DeltaTime
+	ReplayFrameIndex = INDEX_NONE;
+	ReplayRequestFrame = GFrameCounter;
+	ReplayStartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogHappyInputReplay, Display, TEXT("Replaying %d input frames from %s"), Frames.Num(), *FilePath);
+	return true;
+}
+
+void UHappyInputReplaySubsystem::StopReplay()
+{
+	if (!IsReplaying()) return;
+
+	AHappyPlayerController* Controller = ReplayController.Get();
+	ReplayController.Reset();
+
+	FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+
+	const double WallSeconds = FPlatformTime::Seconds() - ReplayStartTime;
+	const int32 PlayedFrames = FMath::Max(ReplayFrameIndex, 0);
+
+	if (APawn* Pawn = Controller ? Controller->GetPawn() : nullptr)
+	{
+		Pawn->EnableInput(Controller);
+
+		// the final transform is the quick way to compare two runs of the same file
+		UE_LOG(LogHappyInputReplay, Display, TEXT("Replay finished: %d frames in %.2f s (%.3f ms/frame), final location %s rotation %s"),
+			PlayedFrames, WallSeconds, PlayedFrames > 0 ? WallSeconds * 1000.0 / PlayedFrames : 0.0,
+			*Pawn->GetActorLocation().ToString(), *Controller->GetControlRotation().ToString());
+	}
+
+	Frames.Reset();
+	ReplayFrameIndex = INDEX_NONE;
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("HappyReplayExit")))
+	{
+		FPlatformMisc::RequestExit(false, TEXT("HappyInputReplay"));
+	}
+}
+
+void UHappyInputReplaySubsystem::RecordAction(EHappyRecordedAction Action, const FVector2D& Value)
+{
+	if (!IsRecording()) return;
+
+	PendingFrame.AddAction(Action);
+
+	if (Action == EHappyRecordedAction::Move)
+	{
+		PendingFrame.Move = FVector2f(Value);
+	}
+	else if (Action == EHappyRecordedAction::Look)
+	{
+		PendingFrame.Look = FVector2f(Value);
+	}
+}
+
+void UHappyInputReplaySubsystem::PreControllerTick(AHappyPlayerController* Controller, float DeltaTime)
+{
+	if (!bCheckedCommandLine && Controller->GetPawn())
+	{
+		bCheckedCommandLine = true;
+
+		FString FilePath;
+		if (FParse::Value(FCommandLine::Get(), TEXT("HappyReplay="), FilePath))
+		{
+			StartReplay(Controller, FilePath);
+		}
+		else if (FParse::Value(FCommandLine::Get(), TEXT("HappyRecord="), FilePath))
+		{
+			StartRecording(Controller, FilePath);
+		}
+	}
+
+	if (bRecordStartPending && RecordController.Get() == Controller)
+	{
+		if (AHappyHazardCharacter* Character = Cast<AHappyHazardCharacter>(Controller->GetPawn()))
+		{
+			Character->CaptureReplayState(StartState);
+		}
+		bRecordStartPending = false;
+		PendingFrame = FHappyInputFrame();
+	}
+
+	if (ReplayController.Get() != Controller) return;
+
+	if (ReplayFrameIndex == INDEX_NONE && GFrameCounter == ReplayRequestFrame) return;
+
+	AHappyHazardCharacter* Character = Cast<AHappyHazardCharacter>(Controller->GetPawn());
+	if (!Character || ReplayFrameIndex >= Frames.Num())
+	{
+		StopReplay();
+		return;
+	}
+
+	// first replay tick: the pawn starts where the recording did, and frame 0 is applied on this same tick
+	if (ReplayFrameIndex == INDEX_NONE)
+	{
+		Character->RestoreReplayState(StartState);
+		ReplayFrameIndex = 0;
+	}
+
+	FeedFrame(Character, Frames[ReplayFrameIndex]);
+	ReplayFrameIndex++;
+
+	if (Frames.IsValidIndex(ReplayFrameIndex))
+	{
+		FApp::SetFixedDeltaTime(Frames[ReplayFrameIndex].DeltaTime);
+	}
+}
+
+void UHappyInputReplaySubsystem::PostControllerTick(AHappyPlayerController* Controller, float DeltaTime)
+{
+	if (RecordController.Get() != Controller || bRecordStartPending) return;
+
+	LLM_SCOPE_BYTAG(HappyHazard_Replay);
+
+	PendingFrame.DeltaTime = DeltaTime;
+	Frames.Add(PendingFrame);
+	PendingFrame = FHappyInputFrame();
+}
+
+void UHappyInputReplaySubsystem::FeedFrame(AHappyHazardCharacter* Character, const FHappyInputFrame& Frame)
+{
+	for (uint8 Action = 0; Action < static_cast<uint8>(EHappyRecordedAction::Count); Action++)
+	{
+		const EHappyRecordedAction RecordedAction = static_cast<EHappyRecordedAction>(Action);
+		if (!Frame.HasAction(RecordedAction)) continue;
+
+		FVector2D Value = FVector2D::ZeroVector;
+		if (RecordedAction == EHappyRecordedAction::Move)
+		{
+			Value = FVector2D(Frame.Move);
+		}
+		else if (RecordedAction == EHappyRecordedAction::Look)
+		{
+			Value = FVector2D(Frame.Look);
+		}
+
+		Character->ReplayInput(RecordedAction, Value);
+	}
+}
+
+bool UHappyInputReplaySubsystem::SaveRecording() const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = HappyInputReplay::FileMagic;
+	uint32 Version = HappyInputReplay::FileVersion;
+	int32 FrameCount = Frames.Num();
+	FHappyReplayStartState State = StartState;
+
+	Writer << Magic << Version << State << FrameCount;
+
+	for (FHappyInputFrame Frame : Frames)
+	{
+		Writer << Frame;
+	}
+
+	return FFileHelper::SaveArrayToFile(Bytes, *RecordFilePath);
+}
+
+bool UHappyInputReplaySubsystem::LoadRecording(const FString& FilePath)
+{
+	LLM_SCOPE_BYTAG(HappyHazard_Replay);
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath)) return false;
+
+	FMemoryReader Reader(Bytes);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 FrameCount = 0;
+
+	Reader << Magic << Version;
+	if (Magic != HappyInputReplay::FileMagic || Version != HappyInputReplay::FileVersion) return false;
+
+	Reader << StartState << FrameCount;
+	if (Reader.IsError() || FrameCount < 0) return false;
+
+	// a corrupt count must not turn into a huge allocation
+	if (FrameCount > (Reader.TotalSize() - Reader.Tell()) / HappyInputReplay::MinFrameBytes) return false;
+
+	Frames.SetNum(FrameCount);
+	for (FHappyInputFrame& Frame : Frames)
+	{
+		Reader << Frame;
+		if (Reader.IsError()) return false;
+	}
+
+	return !Reader.IsError();
+}
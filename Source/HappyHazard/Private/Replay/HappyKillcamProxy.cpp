@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Replay/HappyKillcamProxy.h"
+#include "Camera/CameraComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+
+// Sets default values
+AHappyKillcamProxy::AHappyKillcamProxy()
+{
+	// moved by UHappyKillcamSubsystem
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(FName("Root"));
+
+	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(FName("Mesh"));
+	Mesh->SetupAttachment(RootComponent);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(FName("CameraBoom"));
+	CameraBoom->SetupAttachment(RootComponent);
+	CameraBoom->TargetArmLength = 300.f;
+	CameraBoom->SocketOffset = FVector(0.f, 30.f, 75.f);
+	CameraBoom->bDoCollisionTest = false;
+
+	Camera = CreateDefaultSubobject<UCameraComponent>(FName("Camera"));
+	Camera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+}
+
+void AHappyKillcamProxy::SetupMesh(USkeletalMesh* SkeletalMesh, const FTransform& RelativeTransform, UClass* AnimClass)
+{
+	Mesh->SetSkeletalMesh(SkeletalMesh);
+	Mesh->SetRelativeTransform(RelativeTransform);
+
+	if (AnimClass)
+	{
+		Mesh->SetAnimInstanceClass(AnimClass);
+	}
+}
+
+void AHappyKillcamProxy::ApplyFrame(const FVector& Location, const FRotator& Rotation, float InAimingPercent, float InAimPitch)
+{
+	SetActorLocationAndRotation(Location, Rotation);
+
+	AimingPercent = InAimingPercent;
+	AimPitch = InAimPitch;
+}
+
+void AHappyKillcamProxy::NotifyFired()
+{
+	OnFired();
+}
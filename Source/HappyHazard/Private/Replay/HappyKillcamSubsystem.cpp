@@ -0,0 +1,538 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Replay/HappyKillcamSubsystem.h"
+#include "HappyHazard.h"
+#include "Animation/AnimInstance.h"
+#include "Character/HappyHazardCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "EngineUtils.h"
+#include "Event/HappyGameplayEventBus.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Replay/HappyKillcamProxy.h"
+
+DECLARE_CYCLE_STAT(TEXT("Killcam Tick"), STAT_HappyKillcamTick, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Killcam Tracks"), STAT_HappyKillcamTracks, STATGROUP_HappyHazard);
+DECLARE_MEMORY_STAT(TEXT("Killcam Buffer Memory"), STAT_HappyKillcamMemory, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyKillcam, Log, All);
+
+namespace HappyKillcam
+{
+	// 1 mm steps, int16 then covers 32 m per sample before a new keyframe is forced
+	static constexpr float PositionQuantum = 0.1f;
+
+	// a chunk whose samples would be further apart than a uint16 of ms is split with a new keyframe
+	static constexpr double MaxChunkSeconds = MAX_uint16 / 1000.0;
+
+	// what goes in the ring per keyframe, without the struct padding
+	static constexpr uint64 KeyframeBytes = sizeof(FVector3f) + sizeof(double) + sizeof(int32);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHappyKillcamPlay(
+	TEXT("HappyHazard.Killcam.Play"),
+	TEXT("Play the last seconds back on proxies, seen from the named character or else the one the local player controlled last. Usage: HappyHazard.Killcam.Play [Seconds] [CharacterName]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UHappyKillcamSubsystem* Killcam = World ? World->GetSubsystem<UHappyKillcamSubsystem>() : nullptr)
+		{
+			Killcam->StartPlayback(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.f, Args.Num() > 1 ? FName(*Args[1]) : NAME_None);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdHappyKillcamStop(
+	TEXT("HappyHazard.Killcam.Stop"),
+	TEXT("Stop killcam playback and go back to recording."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyKillcamSubsystem* Killcam = World ? World->GetSubsystem<UHappyKillcamSubsystem>() : nullptr)
+		{
+			Killcam->StopPlayback();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdHappyKillcamStats(
+	TEXT("HappyHazard.Killcam.Stats"),
+	TEXT("Log buffered seconds and bytes per second for every recorded character."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyKillcamSubsystem* Killcam = World ? World->GetSubsystem<UHappyKillcamSubsystem>() : nullptr)
+		{
+			Killcam->DumpStats();
+		}
+	}));
+
+void UHappyKillcamSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UHappyGameplayEventBus* EventBus = Collection.InitializeDependency<UHappyGameplayEventBus>())
+	{
+		EventBus->OnEvents(EHappyEventChannel::Weapon).AddUObject(this, &UHappyKillcamSubsystem::HandleWeaponEvents);
+	}
+}
+
+void UHappyKillcamSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LLM_SCOPE_BYTAG(HappyHazard_Replay);
+
+	SampleInterval = 1.f / GetSamplesPerChunk();
+
+	// every ring is allocated here, recording only writes into them
+	const int32 NumChunks = FMath::Max(BufferSeconds, 1) + 1;
+
+	Tracks.SetNum(FMath::Max(MaxTrackedCharacters, 0));
+	for (FHappyKillcamTrack& Track : Tracks)
+	{
+		Track.Chunks.SetNum(NumChunks);
+		Track.Samples.SetNum(NumChunks * GetSamplesPerChunk());
+	}
+
+	SET_MEMORY_STAT(STAT_HappyKillcamMemory, Tracks.Num() * NumChunks * (sizeof(FHappyKillcamChunk) + GetSamplesPerChunk() * sizeof(FHappyKillcamSample)));
+
+	for (TActorIterator<ACharacter> It(&InWorld); It; ++It)
+	{
+		AddCharacter(*It);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UHappyKillcamSubsystem::OnActorSpawned));
+}
+
+void UHappyKillcamSubsystem::Deinitialize()
+{
+	StopPlayback();
+
+	if (ActorSpawnedHandle.IsValid())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	Tracks.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UHappyKillcamSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyKillcamSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_HappyKillcamTick);
+}
+
+void UHappyKillcamSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (IsPlayingBack())
+	{
+		TickPlayback(DeltaTime);
+		return;
+	}
+
+	TimeUntilSample -= DeltaTime;
+	if (TimeUntilSample > 0.f) return;
+
+	// on a hitch take one sample and carry on, every sample carries its own time
+	TimeUntilSample = FMath::Max(TimeUntilSample + SampleInterval, 0.f);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+	int32 NumRecording = 0;
+	for (FHappyKillcamTrack& Track : Tracks)
+	{
+		if (Track.Character.IsValid())
+		{
+			RecordSample(Track, Now);
+			NumRecording++;
+
+			if (PlayerPawn && Track.Character.Get() == PlayerPawn)
+			{
+				LastPlayerTrackName = Track.CharacterName;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_HappyKillcamTracks, NumRecording);
+}
+
+void UHappyKillcamSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (ACharacter* Character = Cast<ACharacter>(Actor))
+	{
+		AddCharacter(Character);
+	}
+}
+
+void UHappyKillcamSubsystem::AddCharacter(ACharacter* Character)
+{
+	if (!Character || FindTrack(Character)) return;
+
+	// a track no character has had yet, else the one whose character has been gone longest.
+	// a track is taken as soon as it has a character, even before its first sample
+	FHappyKillcamTrack* Track = nullptr;
+	for (FHappyKillcamTrack& Entry : Tracks)
+	{
+		if (Entry.Character.IsValid()) continue;
+
+		if (!Entry.IsInUse())
+		{
+			Track = &Entry;
+			break;
+		}
+
+		if (!Track || Entry.LastSampleTime < Track->LastSampleTime)
+		{
+			Track = &Entry;
+		}
+	}
+
+	if (!Track)
+	{
+		UE_LOG(LogHappyKillcam, Verbose, TEXT("No free killcam track for %s"), *Character->GetName());
+		return;
+	}
+
+	Track->Character = Character;
+	Track->CharacterName = Character->GetFName();
+	Track->Mesh = Character->GetMesh()->GetSkeletalMeshAsset();
+	Track->MeshRelativeTransform = Character->GetMesh()->GetRelativeTransform();
+	Track->HeadChunk = INDEX_NONE;
+	Track->NumChunksUsed = 0;
+	Track->PendingFlags = EHappyKillcamFlags::None;
+	Track->bNeedsKeyframe = false;
+	Track->RecordStartTime = GetWorld()->GetTimeSeconds();
+	Track->LastSampleTime = Track->RecordStartTime;
+	Track->BytesWritten = 0;
+}
+
+void UHappyKillcamSubsystem::HandleWeaponEvents(TConstArrayView<FHappyGameplayEvent> Events)
+{
+	for (const FHappyGameplayEvent& Event : Events)
+	{
+		if (Event.Type != EHappyEventType::Fire) continue;
+
+		// the source is the weapon when one is equipped, owned by the character
+		AActor* Source = Event.Source.Get();
+		ACharacter* Character = Cast<ACharacter>(Source);
+		if (!Character && Source)
+		{
+			Character = Cast<ACharacter>(Source->GetOwner());
+		}
+
+		if (FHappyKillcamTrack* Track = FindTrack(Character))
+		{
+			Track->PendingFlags |= EHappyKillcamFlags::Fired;
+		}
+	}
+}
+
+void UHappyKillcamSubsystem::RecordSample(FHappyKillcamTrack& Track, double Time)
+{
+	const ACharacter* Character = Track.Character.Get();
+	const int32 SamplesPerChunk = GetSamplesPerChunk();
+
+	const FVector3f Location(Character->GetActorLocation());
+
+	bool bNeedKeyframe = Track.bNeedsKeyframe || !Track.IsInUse()
+		|| Track.Chunks[Track.HeadChunk].NumSamples >= SamplesPerChunk
+		|| Time - Track.Chunks[Track.HeadChunk].StartTime > HappyKillcam::MaxChunkSeconds;
+
+	FIntVector Delta = FIntVector::ZeroValue;
+	if (!bNeedKeyframe)
+	{
+		const FVector3f Offset = (Location - Track.LastEncodedLocation) / HappyKillcam::PositionQuantum;
+		Delta = FIntVector(FMath::RoundToInt(Offset.X), FMath::RoundToInt(Offset.Y), FMath::RoundToInt(Offset.Z));
+
+		// teleported, start a new chunk rather than clamp
+		bNeedKeyframe = FMath::Abs(Delta.X) > MAX_int16 || FMath::Abs(Delta.Y) > MAX_int16 || FMath::Abs(Delta.Z) > MAX_int16;
+	}
+
+	if (bNeedKeyframe)
+	{
+		Track.HeadChunk = (Track.HeadChunk + 1) % Track.Chunks.Num();
+		Track.NumChunksUsed = FMath::Min(Track.NumChunksUsed + 1, Track.Chunks.Num());
+
+		FHappyKillcamChunk& Chunk = Track.Chunks[Track.HeadChunk];
+		Chunk.KeyLocation = Location;
+		Chunk.StartTime = Time;
+		Chunk.NumSamples = 0;
+
+		Track.LastEncodedLocation = Location;
+		Track.bNeedsKeyframe = false;
+		Track.BytesWritten += HappyKillcam::KeyframeBytes;
+		Delta = FIntVector::ZeroValue;
+	}
+
+	float AimingPercent = 0.f;
+	bool bAiming = false;
+	if (const AHappyHazardCharacter* HappyCharacter = Cast<AHappyHazardCharacter>(Character))
+	{
+		AimingPercent = HappyCharacter->GetAimingPercent();
+		bAiming = HappyCharacter->GetIsAiming();
+	}
+
+	FHappyKillcamChunk& Chunk = Track.Chunks[Track.HeadChunk];
+	FHappyKillcamSample& Sample = Track.Samples[Track.HeadChunk * SamplesPerChunk + Chunk.NumSamples];
+	Chunk.NumSamples++;
+
+	Sample.TimeOffsetMs = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt((Time - Chunk.StartTime) * 1000.0), 0, static_cast<int32>(MAX_uint16)));
+	Sample.DeltaX = static_cast<int16>(Delta.X);
+	Sample.DeltaY = static_cast<int16>(Delta.Y);
+	Sample.DeltaZ = static_cast<int16>(Delta.Z);
+	Sample.Yaw = FRotator::CompressAxisToShort(Character->GetActorRotation().Yaw);
+	Sample.Pitch = FRotator::CompressAxisToShort(Character->GetBaseAimRotation().Pitch);
+	Sample.AimingPercent = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(AimingPercent, 0.f, 1.f) * 255.f));
+	Sample.Flags = Track.PendingFlags | (bAiming ? EHappyKillcamFlags::Aiming : EHappyKillcamFlags::None);
+
+	Track.PendingFlags = EHappyKillcamFlags::None;
+	Track.LastEncodedLocation += FVector3f(Delta) * HappyKillcam::PositionQuantum;
+	Track.LastSampleTime = Time;
+	Track.BytesWritten += sizeof(FHappyKillcamSample);
+}
+
+void UHappyKillcamSubsystem::DecodeTrack(const FHappyKillcamTrack& Track, double FromTime, TArray<FDecodedFrame>& OutFrames) const
+{
+	const int32 NumChunks = Track.Chunks.Num();
+	const int32 SamplesPerChunk = GetSamplesPerChunk();
+
+	// oldest chunk first
+	for (int32 Age = Track.NumChunksUsed - 1; Age >= 0; Age--)
+	{
+		const int32 ChunkIndex = (Track.HeadChunk - Age + NumChunks) % NumChunks;
+		const FHappyKillcamChunk& Chunk = Track.Chunks[ChunkIndex];
+
+		FVector3f Location = Chunk.KeyLocation;
+
+		for (int32 Index = 0; Index < Chunk.NumSamples; Index++)
+		{
+			const FHappyKillcamSample& Sample = Track.Samples[ChunkIndex * SamplesPerChunk + Index];
+			Location += FVector3f(FIntVector(Sample.DeltaX, Sample.DeltaY, Sample.DeltaZ)) * HappyKillcam::PositionQuantum;
+
+			const double Time = Chunk.StartTime + Sample.TimeOffsetMs / 1000.0;
+			if (Time < FromTime) continue;
+
+			FDecodedFrame& Frame = OutFrames.AddDefaulted_GetRef();
+			Frame.Time = Time;
+			Frame.Location = FVector(Location);
+			Frame.Rotation = FRotator(0.f, FRotator::DecompressAxisFromShort(Sample.Yaw), 0.f);
+			Frame.AimPitch = FRotator::NormalizeAxis(FRotator::DecompressAxisFromShort(Sample.Pitch));
+			Frame.AimingPercent = Sample.AimingPercent / 255.f;
+			Frame.Flags = Sample.Flags;
+		}
+	}
+}
+
+bool UHappyKillcamSubsystem::StartPlayback(float Seconds, FName FocusName)
+{
+	StopPlayback();
+
+	if (FocusName.IsNone())
+	{
+		FocusName = LastPlayerTrackName;
+	}
+
+	double LatestTime = 0.0;
+	for (const FHappyKillcamTrack& Track : Tracks)
+	{
+		if (Track.IsInUse())
+		{
+			LatestTime = FMath::Max(LatestTime, Track.LastSampleTime);
+		}
+	}
+
+	const double FromTime = LatestTime - FMath::Clamp(Seconds, 0.f, static_cast<float>(BufferSeconds));
+
+	UClass* AnimClass = ProxyAnimClass.LoadSynchronous();
+	AHappyKillcamProxy* FocusProxy = nullptr;
+
+	for (const FHappyKillcamTrack& Track : Tracks)
+	{
+		if (!Track.IsInUse()) continue;
+
+		FPlaybackProxy Playback;
+		DecodeTrack(Track, FromTime, Playback.Frames);
+		if (Playback.Frames.Num() == 0) continue;
+
+		const FDecodedFrame& First = Playback.Frames[0];
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		AHappyKillcamProxy* Proxy = GetWorld()->SpawnActor<AHappyKillcamProxy>(AHappyKillcamProxy::StaticClass(), First.Location, First.Rotation, SpawnParams);
+		if (!Proxy) continue;
+
+		Proxy->SetupMesh(Track.Mesh.Get(), Track.MeshRelativeTransform, AnimClass);
+		Proxy->SetActorHiddenInGame(First.Time > FromTime);
+
+		if (!FocusProxy && !FocusName.IsNone() && Track.CharacterName == FocusName)
+		{
+			FocusProxy = Proxy;
+		}
+
+		Playback.Proxy = Proxy;
+		PlaybackProxies.Add(MoveTemp(Playback));
+	}
+
+	if (PlaybackProxies.Num() == 0)
+	{
+		UE_LOG(LogHappyKillcam, Warning, TEXT("Nothing recorded to play back"));
+		return false;
+	}
+
+	PlaybackTime = FromTime;
+	PlaybackEndTime = LatestTime;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && FocusProxy)
+	{
+		SavedViewTarget = PlayerController->GetViewTarget();
+		PlayerController->SetViewTarget(FocusProxy);
+	}
+	else if (!FocusName.IsNone())
+	{
+		UE_LOG(LogHappyKillcam, Warning, TEXT("No recording of %s to focus on"), *FocusName.ToString());
+	}
+
+	UE_LOG(LogHappyKillcam, Log, TEXT("Playing back %.1f s on %d proxies"), PlaybackEndTime - PlaybackTime, PlaybackProxies.Num());
+	return true;
+}
+
+void UHappyKillcamSubsystem::NotifyCharacterDied(ACharacter* Victim)
+{
+	if (!Victim || DeathPlaybackSeconds <= 0.f || IsPlayingBack()) return;
+
+	// called before the corpse lets go of its controller
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController || PlayerController->GetPawn() != Victim) return;
+
+	FHappyKillcamTrack* Track = FindTrack(Victim);
+	if (!Track) return;
+
+	// the ring only has samples up to the last tick, take the death pose before playback pauses recording
+	RecordSample(*Track, GetWorld()->GetTimeSeconds());
+
+	StartPlayback(DeathPlaybackSeconds, Track->CharacterName);
+}
+
+void UHappyKillcamSubsystem::StopPlayback()
+{
+	if (!IsPlayingBack()) return;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && SavedViewTarget.IsValid())
+	{
+		PlayerController->SetViewTarget(SavedViewTarget.Get());
+	}
+	SavedViewTarget.Reset();
+
+	for (FPlaybackProxy& Playback : PlaybackProxies)
+	{
+		if (AHappyKillcamProxy* Proxy = Playback.Proxy.Get())
+		{
+			Proxy->Destroy();
+		}
+	}
+
+	PlaybackProxies.Reset();
+
+	// the gap is not in the ring, start fresh chunks after it
+	for (FHappyKillcamTrack& Track : Tracks)
+	{
+		Track.bNeedsKeyframe = true;
+	}
+}
+
+void UHappyKillcamSubsystem::TickPlayback(float DeltaTime)
+{
+	PlaybackTime += DeltaTime;
+
+	for (FPlaybackProxy& Playback : PlaybackProxies)
+	{
+		AHappyKillcamProxy* Proxy = Playback.Proxy.Get();
+		if (!Proxy) continue;
+
+		const TArray<FDecodedFrame>& Frames = Playback.Frames;
+
+		bool bFired = false;
+		while (Playback.Cursor + 1 < Frames.Num() && Frames[Playback.Cursor + 1].Time <= PlaybackTime)
+		{
+			Playback.Cursor++;
+			bFired |= EnumHasAnyFlags(Frames[Playback.Cursor].Flags, EHappyKillcamFlags::Fired);
+		}
+
+		// not spawned yet or already gone at this point of the recording
+		const bool bOutside = PlaybackTime < Frames[0].Time || (Playback.Cursor + 1 >= Frames.Num() && PlaybackTime > Frames.Last().Time + SampleInterval);
+		Proxy->SetActorHiddenInGame(bOutside);
+		if (bOutside) continue;
+
+		const FDecodedFrame& From = Frames[Playback.Cursor];
+		const FDecodedFrame& To = Frames[FMath::Min(Playback.Cursor + 1, Frames.Num() - 1)];
+		const float Alpha = To.Time > From.Time ? FMath::Clamp(static_cast<float>((PlaybackTime - From.Time) / (To.Time - From.Time)), 0.f, 1.f) : 0.f;
+
+		Proxy->ApplyFrame(
+			FMath::Lerp(From.Location, To.Location, Alpha),
+			FQuat::Slerp(From.Rotation.Quaternion(), To.Rotation.Quaternion(), Alpha).Rotator(),
+			FMath::Lerp(From.AimingPercent, To.AimingPercent, Alpha),
+			FMath::Lerp(From.AimPitch, To.AimPitch, Alpha));
+
+		if (bFired)
+		{
+			Proxy->NotifyFired();
+		}
+	}
+
+	if (PlaybackTime >= PlaybackEndTime)
+	{
+		StopPlayback();
+	}
+}
+
+FHappyKillcamTrack* UHappyKillcamSubsystem::FindTrack(const ACharacter* Character)
+{
+	if (!Character) return nullptr;
+
+	return Tracks.FindByPredicate([Character](const FHappyKillcamTrack& Track) { return Track.Character.Get() == Character; });
+}
+
+void UHappyKillcamSubsystem::DumpStats() const
+{
+	uint64 TotalBytesPerSecond = 0;
+	int32 NumTracks = 0;
+
+	const int32 TrackBytes = Tracks.Num() > 0 ? static_cast<int32>(Tracks[0].Chunks.Num() * (sizeof(FHappyKillcamChunk) + GetSamplesPerChunk() * sizeof(FHappyKillcamSample))) : 0;
+
+	UE_LOG(LogHappyKillcam, Display, TEXT("Killcam %d Hz, %d s buffer, %d tracks of %d bytes"), GetSamplesPerChunk(), BufferSeconds, Tracks.Num(), TrackBytes);
+
+	for (const FHappyKillcamTrack& Track : Tracks)
+	{
+		if (!Track.IsInUse()) continue;
+
+		const double RecordedSeconds = FMath::Max(Track.LastSampleTime - Track.RecordStartTime, 0.001);
+		const double BytesPerSecond = Track.BytesWritten / RecordedSeconds;
+
+		double BufferedSeconds = 0.0;
+		if (Track.NumChunksUsed > 0)
+		{
+			const int32 OldestChunk = (Track.HeadChunk - Track.NumChunksUsed + 1 + Track.Chunks.Num()) % Track.Chunks.Num();
+			BufferedSeconds = Track.LastSampleTime - Track.Chunks[OldestChunk].StartTime;
+		}
+
+		UE_LOG(LogHappyKillcam, Display, TEXT("  %-32s %6.0f B/s  %5.1f s buffered%s"),
+			*Track.CharacterName.ToString(), BytesPerSecond, BufferedSeconds, Track.Character.IsValid() ? TEXT("") : TEXT("  (gone)"));
+
+		TotalBytesPerSecond += static_cast<uint64>(BytesPerSecond);
+		NumTracks++;
+	}
+
+	UE_LOG(LogHappyKillcam, Display, TEXT("  %d characters, %llu B/s total"), NumTracks, TotalBytesPerSecond);
+}
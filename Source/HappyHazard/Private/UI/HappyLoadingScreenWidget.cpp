@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UI/HappyLoadingScreenWidget.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/Border.h"
+#include "Components/TextBlock.h"
+
+TSharedRef<SWidget> UHappyLoadingScreenWidget::RebuildWidget()
+{
+	// a native class has no designer tree, so the default one is built here the first time
+	if (WidgetTree && !WidgetTree->RootWidget)
+	{
+		UBorder* Background = WidgetTree->ConstructWidget<UBorder>(UBorder::StaticClass(), TEXT("Background"));
+		Background->SetBrushColor(FLinearColor::Black);
+		Background->SetHorizontalAlignment(HAlign_Right);
+		Background->SetVerticalAlignment(VAlign_Bottom);
+		Background->SetPadding(FMargin(48.f));
+
+		UTextBlock* LoadingText = WidgetTree->ConstructWidget<UTextBlock>(UTextBlock::StaticClass(), TEXT("LoadingText"));
+		LoadingText->SetText(NSLOCTEXT("HappyHazard", "LoadingScreenText", "Loading..."));
+		Background->SetContent(LoadingText);
+
+		WidgetTree->RootWidget = Background;
+	}
+
+	return Super::RebuildWidget();
+}
@@ -2,7 +2,11 @@
 
 
 #include "UI/PlayerHUD.h"
+#include "HappyHazard.h"
+#include "Debug/HappyStartupProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 #include "UI/AimCrossHairWidget.h"
+#include "Event/HappyGameplayEventBus.h"
 
 void APlayerHUD::DrawHUD()
 {
@@ -29,6 +33,10 @@ void APlayerHUD::SetAimDisplay(bool bVisible)
 
 void APlayerHUD::BeginPlay()
 {
+    LLM_SCOPE_BYTAG(HappyHazard_UI);
+    TRACE_CPUPROFILER_EVENT_SCOPE(APlayerHUD::BeginPlay);
+    FHappyStartupPhaseScope StartupPhase(TEXT("PlayerHUDBeginPlay"));
+
     Super::BeginPlay();
 
     if (AimCrossHairWidgetClass != nullptr)
@@ -37,6 +45,36 @@ void APlayerHUD::BeginPlay()
         if (HUDAimWidget != nullptr)
         {
             HUDAimWidget->AddToViewport();
+            SetAimDisplay(false);
+        }
+    }
+
+    if (UHappyGameplayEventBus* EventBus = GetWorld()->GetSubsystem<UHappyGameplayEventBus>())
+    {
+        EventBus->OnEvents(EHappyEventChannel::Aim).AddUObject(this, &APlayerHUD::HandleAimEvents);
+    }
+}
+
+void APlayerHUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UHappyGameplayEventBus* EventBus = GetWorld()->GetSubsystem<UHappyGameplayEventBus>())
+    {
+        EventBus->OnEvents(EHappyEventChannel::Aim).RemoveAll(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void APlayerHUD::HandleAimEvents(TConstArrayView<FHappyGameplayEvent> Events)
+{
+    // only the latest state of our own pawn matters
+    for (int32 Index = Events.Num() - 1; Index >= 0; Index--)
+    {
+        const FHappyGameplayEvent& Event = Events[Index];
+        if (Event.Source.Get() == GetOwningPawn())
+        {
+            SetAimDisplay(Event.Value > 0.f);
+            return;
         }
     }
 }
\ No newline at end of file
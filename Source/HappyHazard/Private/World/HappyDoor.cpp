@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/HappyDoor.h"
+#include "Components/BoxComponent.h"
+#include "GameFramework/Pawn.h"
+#include "World/HappyRoomStreamingSubsystem.h"
+#include "World/HappyRoomVolume.h"
+
+AHappyDoor::AHappyDoor()
+{
+	// doors only react to overlaps
+	PrimaryActorTick.bCanEverTick = false;
+
+	ApproachTrigger = CreateDefaultSubobject<UBoxComponent>(FName("ApproachTrigger"));
+	ApproachTrigger->SetBoxExtent(FVector(200.f, 150.f, 100.f));
+	ApproachTrigger->SetCollisionProfileName(TEXT("Trigger"));
+	RootComponent = ApproachTrigger;
+}
+
+void AHappyDoor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ApproachTrigger->OnComponentBeginOverlap.AddDynamic(this, &AHappyDoor::OnApproachBeginOverlap);
+}
+
+AHappyRoomVolume* AHappyDoor::GetOtherRoom(const FVector& Point) const
+{
+	if (RoomA && RoomA->ContainsPoint(Point))
+	{
+		return RoomB;
+	}
+
+	if (RoomB && RoomB->ContainsPoint(Point))
+	{
+		return RoomA;
+	}
+
+	// standing in the doorway, bring in whichever side is farther
+	if (RoomA && RoomB)
+	{
+		return FVector::DistSquared(RoomA->GetActorLocation(), Point) > FVector::DistSquared(RoomB->GetActorLocation(), Point) ? RoomA : RoomB;
+	}
+
+	return RoomA ? RoomA : RoomB;
+}
+
+void AHappyDoor::OnApproachBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	APawn* Pawn = Cast<APawn>(OtherActor);
+	if (!Pawn || !Pawn->IsPlayerControlled()) return;
+
+	if (UHappyRoomStreamingSubsystem* RoomStreaming = GetWorld()->GetSubsystem<UHappyRoomStreamingSubsystem>())
+	{
+		RoomStreaming->NotifyDoorApproached(GetOtherRoom(Pawn->GetActorLocation()));
+	}
+}
@@ -0,0 +1,444 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/HappyRoomStreamingSubsystem.h"
+#include "HappyHazard.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "World/HappyRoomVolume.h"
+
+DECLARE_CYCLE_STAT(TEXT("Room Streaming Tick"), STAT_HappyRoomStreamingTick, STATGROUP_HappyHazard);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rooms Resident"), STAT_HappyRoomsResident, STATGROUP_HappyHazard);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Rooms Resident (est MB)"), STAT_HappyRoomsResidentMB, STATGROUP_HappyHazard);
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyRoomStreaming, Log, All);
+
+static FAutoConsoleCommandWithWorld CmdHappyRoomsEnterCold(
+	TEXT("HappyHazard.Rooms.EnterCold"),
+	TEXT("Teleport the player into a room that isn't loaded. The log should then warn that it was entered before it finished streaming in."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyRoomStreamingSubsystem* RoomStreaming = World ? World->GetSubsystem<UHappyRoomStreamingSubsystem>() : nullptr)
+		{
+			RoomStreaming->EnterColdRoom();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdHappyRooms(
+	TEXT("HappyHazard.Rooms"),
+	TEXT("Log every streamed room with its residency, distance and estimated memory."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UHappyRoomStreamingSubsystem* RoomStreaming = World ? World->GetSubsystem<UHappyRoomStreamingSubsystem>() : nullptr)
+		{
+			RoomStreaming->DumpRooms();
+		}
+	}));
+
+bool UHappyRoomStreamingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHappyRoomStreamingSubsystem::GetStatId() const
+{
+	return GET_STATID(STAT_HappyRoomStreamingTick);
+}
+
+void UHappyRoomStreamingSubsystem::RegisterRoom(AHappyRoomVolume* Room)
+{
+	if (!Room || FindState(Room)) return;
+
+	FHappyRoomStreamingState& State = Rooms.AddDefaulted_GetRef();
+	State.Room = Room;
+
+	// sublevels set to load with the persistent level are already resident
+	const FName PackageName = Room->GetRoomLevel().ToSoftObjectPath().GetLongPackageFName();
+	for (ULevelStreaming* Streaming : GetWorld()->GetStreamingLevels())
+	{
+		if (Streaming && FName(*UWorld::RemovePIEPrefix(Streaming->GetWorldAssetPackageName())) == PackageName)
+		{
+			State.Streaming = Streaming;
+			State.bResident = Streaming->ShouldBeLoaded();
+			State.bVisible = Streaming->IsLevelVisible();
+
+			// when it is still on its way in, the load log times it from registration instead of from zero
+			State.RequestTime = FPlatformTime::Seconds();
+			State.UsedPhysicalAtRequest = FPlatformMemory::GetStats().UsedPhysical;
+			break;
+		}
+	}
+}
+
+void UHappyRoomStreamingSubsystem::UnregisterRoom(AHappyRoomVolume* Room)
+{
+	Rooms.RemoveAll([Room](const FHappyRoomStreamingState& State) { return State.Room.Get() == Room || !State.Room.IsValid(); });
+}
+
+void UHappyRoomStreamingSubsystem::NotifyDoorApproached(AHappyRoomVolume* NextRoom)
+{
+	if (!NextRoom) return;
+
+	DoorHintRoom = NextRoom;
+	DoorHintTime = GetWorld()->GetTimeSeconds();
+
+	// don't wait for the next update, the door may be opened right away
+	if (FHappyRoomStreamingState* State = FindState(NextRoom))
+	{
+		// wanted just now, so the budget won't pick the room the player is about to walk into
+		State->bWanted = true;
+		State->LastWantedTime = GetWorld()->GetTimeSeconds();
+		if (!State->bResident)
+		{
+			RequestLoad(*State);
+		}
+	}
+}
+
+void UHappyRoomStreamingSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Rooms.Num() == 0) return;
+
+	UpdateLoadProgress(DeltaTime);
+
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0.f)
+	{
+		TimeUntilUpdate = UpdateInterval;
+
+		UpdateWantedRooms();
+		EnforceBudget();
+	}
+
+	int32 NumResident = 0;
+	float ResidentMB = 0.f;
+	for (const FHappyRoomStreamingState& State : Rooms)
+	{
+		if (State.bResident && State.Room.IsValid())
+		{
+			NumResident++;
+			ResidentMB += State.Room->GetEstimatedMemoryMB();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_HappyRoomsResident, NumResident);
+	SET_FLOAT_STAT(STAT_HappyRoomsResidentMB, ResidentMB);
+}
+
+void UHappyRoomStreamingSubsystem::UpdateWantedRooms()
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (!Pawn) return;
+
+	const FVector PawnLocation = Pawn->GetActorLocation();
+
+	AHappyRoomVolume* NewRoom = CurrentRoom.Get();
+	if (!NewRoom || !NewRoom->ContainsPoint(PawnLocation))
+	{
+		NewRoom = nullptr;
+		for (const FHappyRoomStreamingState& State : Rooms)
+		{
+			if (State.Room.IsValid() && State.Room->ContainsPoint(PawnLocation))
+			{
+				NewRoom = State.Room.Get();
+				break;
+			}
+		}
+	}
+
+	// in a gap between volumes, keep what we have
+	if (!NewRoom) return;
+
+	if (NewRoom != CurrentRoom.Get())
+	{
+		CurrentRoom = NewRoom;
+		UE_LOG(LogHappyRoomStreaming, Log, TEXT("Entered room %s"), *NewRoom->GetName());
+
+		FHappyRoomStreamingState* State = FindState(NewRoom);
+		if (State && !State->bVisible)
+		{
+			State->bEnteredBeforeVisible = true;
+		}
+	}
+
+	TSet<AHappyRoomVolume*> WantedRooms;
+	WantedRooms.Add(NewRoom);
+
+	for (AHappyRoomVolume* Neighbour : NewRoom->GetNeighbours())
+	{
+		WantedRooms.Add(Neighbour);
+	}
+
+	// heading for a neighbour, so its neighbours are one door away
+	if (AHappyRoomVolume* PredictedRoom = PredictNextRoom(Pawn))
+	{
+		for (AHappyRoomVolume* Neighbour : PredictedRoom->GetNeighbours())
+		{
+			WantedRooms.Add(Neighbour);
+		}
+	}
+
+	if (DoorHintRoom.IsValid() && GetWorld()->GetTimeSeconds() - DoorHintTime <= DoorHintSeconds)
+	{
+		WantedRooms.Add(DoorHintRoom.Get());
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (FHappyRoomStreamingState& State : Rooms)
+	{
+		State.bWanted = WantedRooms.Contains(State.Room.Get());
+		if (!State.bWanted) continue;
+
+		State.LastWantedTime = Now;
+		if (!State.bResident)
+		{
+			RequestLoad(State);
+		}
+	}
+}
+
+void UHappyRoomStreamingSubsystem::UpdateLoadProgress(float DeltaTime)
+{
+	for (FHappyRoomStreamingState& State : Rooms)
+	{
+		if (!State.bResident || State.bVisible) continue;
+
+		State.MaxFrameMsWhileLoading = FMath::Max(State.MaxFrameMsWhileLoading, DeltaTime * 1000.f);
+
+		ULevelStreaming* Streaming = State.Streaming.Get();
+		if (!Streaming || !Streaming->IsLevelVisible()) continue;
+
+		State.bVisible = true;
+
+		const double LoadSeconds = FPlatformTime::Seconds() - State.RequestTime;
+		const double MeasuredMB = (static_cast<double>(FPlatformMemory::GetStats().UsedPhysical) - State.UsedPhysicalAtRequest) / (1024.0 * 1024.0);
+
+		// measured is the process delta over the load, other allocations land in it too
+		UE_LOG(LogHappyRoomStreaming, Log, TEXT("Room %s visible after %.2f s, worst frame %.1f ms, est %.1f MB, measured %+.1f MB"),
+			*State.Room->GetName(), LoadSeconds, State.MaxFrameMsWhileLoading, State.Room->GetEstimatedMemoryMB(), MeasuredMB);
+
+		if (State.bEnteredBeforeVisible)
+		{
+			UE_LOG(LogHappyRoomStreaming, Warning, TEXT("Room %s was entered before it finished streaming in"), *State.Room->GetName());
+		}
+	}
+}
+
+void UHappyRoomStreamingSubsystem::EnforceBudget()
+{
+	float ResidentMB = 0.f;
+	for (const FHappyRoomStreamingState& State : Rooms)
+	{
+		if (State.bResident && State.Room.IsValid())
+		{
+			ResidentMB += State.Room->GetEstimatedMemoryMB();
+		}
+	}
+
+	if (ResidentMB <= ResidentBudgetMB) return;
+
+	const TMap<const AHappyRoomVolume*, int32> Distances = ComputeRoomDistances();
+
+	TArray<FHappyRoomStreamingState*> Candidates;
+	for (FHappyRoomStreamingState& State : Rooms)
+	{
+		if (State.bResident && !State.bWanted && State.Room.IsValid())
+		{
+			Candidates.Add(&State);
+		}
+	}
+
+	// farthest first, then the one wanted longest ago
+	Candidates.Sort([&Distances](const FHappyRoomStreamingState& A, const FHappyRoomStreamingState& B)
+	{
+		const int32* FoundA = Distances.Find(A.Room.Get());
+		const int32* FoundB = Distances.Find(B.Room.Get());
+		const int32 DistanceA = FoundA ? *FoundA : MAX_int32;
+		const int32 DistanceB = FoundB ? *FoundB : MAX_int32;
+
+		if (DistanceA != DistanceB) return DistanceA > DistanceB;
+		return A.LastWantedTime < B.LastWantedTime;
+	});
+
+	for (FHappyRoomStreamingState* State : Candidates)
+	{
+		if (ResidentMB <= ResidentBudgetMB) break;
+
+		ResidentMB -= State->Room->GetEstimatedMemoryMB();
+		RequestUnload(*State);
+	}
+}
+
+void UHappyRoomStreamingSubsystem::RequestLoad(FHappyRoomStreamingState& State)
+{
+	ULevelStreaming* Streaming = State.Streaming.Get();
+	if (!Streaming)
+	{
+		Streaming = FindOrCreateStreaming(State.Room.Get());
+		State.Streaming = Streaming;
+	}
+
+	if (!Streaming)
+	{
+		UE_LOG(LogHappyRoomStreaming, Warning, TEXT("Room %s has no streamable level"), *GetNameSafe(State.Room.Get()));
+		return;
+	}
+
+	Streaming->SetShouldBeLoaded(true);
+	Streaming->SetShouldBeVisible(true);
+
+	State.bResident = true;
+	State.bVisible = false;
+	State.RequestTime = FPlatformTime::Seconds();
+	State.UsedPhysicalAtRequest = FPlatformMemory::GetStats().UsedPhysical;
+	State.MaxFrameMsWhileLoading = 0.f;
+}
+
+void UHappyRoomStreamingSubsystem::RequestUnload(FHappyRoomStreamingState& State)
+{
+	if (ULevelStreaming* Streaming = State.Streaming.Get())
+	{
+		Streaming->SetShouldBeVisible(false);
+		Streaming->SetShouldBeLoaded(false);
+	}
+
+	State.bResident = false;
+	State.bVisible = false;
+
+	// cleared here and not in RequestLoad, walking into a cold room flags it right before its load is requested
+	State.bEnteredBeforeVisible = false;
+
+	UE_LOG(LogHappyRoomStreaming, Log, TEXT("Unloading room %s for memory budget"), *GetNameSafe(State.Room.Get()));
+}
+
+ULevelStreaming* UHappyRoomStreamingSubsystem::FindOrCreateStreaming(AHappyRoomVolume* Room)
+{
+	if (!Room || Room->GetRoomLevel().IsNull()) return nullptr;
+
+	const FName PackageName = Room->GetRoomLevel().ToSoftObjectPath().GetLongPackageFName();
+	for (ULevelStreaming* Streaming : GetWorld()->GetStreamingLevels())
+	{
+		if (Streaming && FName(*UWorld::RemovePIEPrefix(Streaming->GetWorldAssetPackageName())) == PackageName)
+		{
+			return Streaming;
+		}
+	}
+
+	// not added to the persistent level, stream it in as an instance at its authored origin
+	bool bSuccess = false;
+	ULevelStreamingDynamic* Instance = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(GetWorld(), Room->GetRoomLevel(), FVector::ZeroVector, FRotator::ZeroRotator, bSuccess);
+
+	return bSuccess ? Instance : nullptr;
+}
+
+FHappyRoomStreamingState* UHappyRoomStreamingSubsystem::FindState(const AHappyRoomVolume* Room)
+{
+	return Rooms.FindByPredicate([Room](const FHappyRoomStreamingState& State) { return State.Room.Get() == Room; });
+}
+
+AHappyRoomVolume* UHappyRoomStreamingSubsystem::PredictNextRoom(const APawn* Pawn) const
+{
+	const AHappyRoomVolume* Room = CurrentRoom.Get();
+	const FVector Velocity = Pawn->GetVelocity();
+	if (!Room || Velocity.Size2D() < PredictMinSpeed) return nullptr;
+
+	const FVector MoveDirection = Velocity.GetSafeNormal2D();
+
+	AHappyRoomVolume* BestRoom = nullptr;
+	float BestDot = PredictMinDot;
+
+	for (AHappyRoomVolume* Neighbour : Room->GetNeighbours())
+	{
+		if (!Neighbour) continue;
+
+		const FVector ToNeighbour = (Neighbour->GetActorLocation() - Pawn->GetActorLocation()).GetSafeNormal2D();
+		const float Dot = FVector::DotProduct(MoveDirection, ToNeighbour);
+		if (Dot > BestDot)
+		{
+			BestDot = Dot;
+			BestRoom = Neighbour;
+		}
+	}
+
+	return BestRoom;
+}
+
+TMap<const AHappyRoomVolume*, int32> UHappyRoomStreamingSubsystem::ComputeRoomDistances() const
+{
+	TMap<const AHappyRoomVolume*, int32> Distances;
+
+	const AHappyRoomVolume* StartRoom = CurrentRoom.Get();
+	if (!StartRoom) return Distances;
+
+	TArray<const AHappyRoomVolume*> Queue;
+	Queue.Add(StartRoom);
+	Distances.Add(StartRoom, 0);
+
+	for (int32 Index = 0; Index < Queue.Num(); Index++)
+	{
+		const AHappyRoomVolume* Room = Queue[Index];
+		const int32 Distance = Distances[Room];
+
+		for (const AHappyRoomVolume* Neighbour : Room->GetNeighbours())
+		{
+			if (Neighbour && !Distances.Contains(Neighbour))
+			{
+				Distances.Add(Neighbour, Distance + 1);
+				Queue.Add(Neighbour);
+			}
+		}
+	}
+
+	return Distances;
+}
+
+void UHappyRoomStreamingSubsystem::EnterColdRoom()
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (!Pawn) return;
+
+	for (const FHappyRoomStreamingState& State : Rooms)
+	{
+		if (State.bResident || !State.Room.IsValid()) continue;
+
+		UE_LOG(LogHappyRoomStreaming, Display, TEXT("Teleporting into cold room %s, expect an entered before streamed in warning once it is visible"), *State.Room->GetName());
+
+		Pawn->TeleportTo(State.Room->GetActorLocation(), Pawn->GetActorRotation(), false, true);
+
+		// notice the room on the next tick instead of after the update interval
+		TimeUntilUpdate = 0.f;
+		return;
+	}
+
+	UE_LOG(LogHappyRoomStreaming, Warning, TEXT("No cold room to enter, every room is resident (lower ResidentBudgetMB or move away first)"));
+}
+
+void UHappyRoomStreamingSubsystem::DumpRooms() const
+{
+	const TMap<const AHappyRoomVolume*, int32> Distances = ComputeRoomDistances();
+
+	UE_LOG(LogHappyRoomStreaming, Display, TEXT("Current room %s, budget %.0f MB"), *GetNameSafe(CurrentRoom.Get()), ResidentBudgetMB);
+
+	for (const FHappyRoomStreamingState& State : Rooms)
+	{
+		if (!State.Room.IsValid()) continue;
+
+		const int32* Distance = Distances.Find(State.Room.Get());
+
+		UE_LOG(LogHappyRoomStreaming, Display, TEXT("  %-32s %-10s %-8s doors %2d  est %6.1f MB"),
+			*State.Room->GetName(),
+			State.bVisible ? TEXT("visible") : (State.bResident ? TEXT("loading") : TEXT("unloaded")),
+			State.bWanted ? TEXT("wanted") : TEXT(""),
+			Distance ? *Distance : -1,
+			State.Room->GetEstimatedMemoryMB());
+	}
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/HappyRoomVolume.h"
+#include "Components/BoxComponent.h"
+#include "World/HappyRoomStreamingSubsystem.h"
+
+// Sets default values
+AHappyRoomVolume::AHappyRoomVolume()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RoomBounds = CreateDefaultSubobject<UBoxComponent>(FName("RoomBounds"));
+	RoomBounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RoomBounds->SetBoxExtent(FVector(500.f, 500.f, 200.f));
+	RootComponent = RoomBounds;
+
+}
+
+// Called when the game starts or when spawned
+void AHappyRoomVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UHappyRoomStreamingSubsystem* RoomStreaming = GetWorld()->GetSubsystem<UHappyRoomStreamingSubsystem>())
+	{
+		RoomStreaming->RegisterRoom(this);
+	}
+}
+
+void AHappyRoomVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UHappyRoomStreamingSubsystem* RoomStreaming = GetWorld()->GetSubsystem<UHappyRoomStreamingSubsystem>())
+	{
+		RoomStreaming->UnregisterRoom(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AHappyRoomVolume::ContainsPoint(const FVector& Point) const
+{
+	const FVector LocalPoint = RoomBounds->GetComponentTransform().InverseTransformPosition(Point);
+	const FVector Extent = RoomBounds->GetUnscaledBoxExtent();
+
+	return FMath::Abs(LocalPoint.X) <= Extent.X && FMath::Abs(LocalPoint.Y) <= Extent.Y && FMath::Abs(LocalPoint.Z) <= Extent.Z;
+}
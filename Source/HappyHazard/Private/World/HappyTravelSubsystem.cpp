@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "World/HappyTravelSubsystem.h"
+#include "Blueprint/UserWidget.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/GameViewportClient.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "UI/HappyLoadingScreenWidget.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogHappyTravel, Log, All);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHappyTravel(
+	TEXT("HappyHazard.Travel"),
+	TEXT("Preload a map behind the loading screen and seamless travel to it. Usage: HappyHazard.Travel /Game/Path/To/Map"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		UHappyTravelSubsystem* TravelSubsystem = GameInstance ? GameInstance->GetSubsystem<UHappyTravelSubsystem>() : nullptr;
+		if (TravelSubsystem && Args.Num() > 0)
+		{
+			TravelSubsystem->TravelTo(Args[0]);
+		}
+	}));
+
+void UHappyTravelSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (GEngine)
+	{
+		GEngine->OnTravelFailure().AddUObject(this, &UHappyTravelSubsystem::HandleTravelFailure);
+	}
+}
+
+void UHappyTravelSubsystem::Deinitialize()
+{
+	if (GEngine)
+	{
+		GEngine->OnTravelFailure().RemoveAll(this);
+	}
+
+	HideLoadingScreen();
+
+	Super::Deinitialize();
+}
+
+void UHappyTravelSubsystem::TravelTo(const FString& MapName)
+{
+	if (bTraveling)
+	{
+		UE_LOG(LogHappyTravel, Warning, TEXT("Already traveling to %s, ignoring %s"), *DestinationMap, *MapName);
+		return;
+	}
+
+	if (!FPackageName::IsValidLongPackageName(MapName) || !FPackageName::DoesPackageExist(MapName))
+	{
+		UE_LOG(LogHappyTravel, Warning, TEXT("No map package %s"), *MapName);
+		return;
+	}
+
+	bTraveling = true;
+	DestinationMap = MapName;
+	RequestTime = FPlatformTime::Seconds();
+
+	ShowLoadingScreen();
+
+	LoadPackageAsync(MapName, FLoadPackageAsyncDelegate::CreateUObject(this, &UHappyTravelSubsystem::OnDestinationPreloaded));
+}
+
+void UHappyTravelSubsystem::OnDestinationPreloaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+{
+	if (!bTraveling) return;
+
+	PreloadedTime = FPlatformTime::Seconds();
+
+	if (Result != EAsyncLoadingResult::Succeeded || !Package)
+	{
+		UE_LOG(LogHappyTravel, Error, TEXT("Preloading %s failed"), *PackageName.ToString());
+		bTraveling = false;
+		HideLoadingScreen();
+		return;
+	}
+
+	PreloadedPackage = Package;
+
+	UE_LOG(LogHappyTravel, Log, TEXT("Preloaded %s in %.2f s"), *PackageName.ToString(), PreloadedTime - RequestTime);
+
+	const float ScreenTimeLeft = MinLoadingScreenSeconds - static_cast<float>(PreloadedTime - RequestTime);
+
+	if (ScreenTimeLeft > 0.f)
+	{
+		GetGameInstance()->GetTimerManager().SetTimer(TravelTimerHandle, FTimerDelegate::CreateUObject(this, &UHappyTravelSubsystem::StartTravel), ScreenTimeLeft, false);
+		return;
+	}
+
+	StartTravel();
+}
+
+void UHappyTravelSubsystem::StartTravel()
+{
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (!World || !World->ServerTravel(DestinationMap))
+	{
+		UE_LOG(LogHappyTravel, Error, TEXT("Could not start travel to %s"), *DestinationMap);
+		bTraveling = false;
+		PreloadedPackage = nullptr;
+		HideLoadingScreen();
+	}
+}
+
+void UHappyTravelSubsystem::NotifyTravelFinished(UWorld* World)
+{
+	if (!bTraveling) return;
+
+	const double PlayableTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogHappyTravel, Log, TEXT("%s playable %.2f s after the travel request (preload %.2f s, travel %.2f s)"),
+		*DestinationMap, PlayableTime - RequestTime, PreloadedTime - RequestTime, PlayableTime - PreloadedTime);
+
+	bTraveling = false;
+	PreloadedPackage = nullptr;
+	HideLoadingScreen();
+}
+
+void UHappyTravelSubsystem::HandleTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString)
+{
+	if (!bTraveling) return;
+
+	UE_LOG(LogHappyTravel, Error, TEXT("Travel to %s failed: %s"), *DestinationMap, *ErrorString);
+
+	bTraveling = false;
+	PreloadedPackage = nullptr;
+	HideLoadingScreen();
+}
+
+void UHappyTravelSubsystem::ShowLoadingScreen()
+{
+	UGameViewportClient* Viewport = GetGameInstance()->GetGameViewportClient();
+	if (!Viewport) return;
+
+	if (!LoadingWidget)
+	{
+		// loaded once and kept, it has to be up before anything else of the destination is
+		UClass* WidgetClass = LoadingWidgetClass.LoadSynchronous();
+		if (!WidgetClass)
+		{
+			WidgetClass = UHappyLoadingScreenWidget::StaticClass();
+		}
+
+		LoadingWidget = CreateWidget<UUserWidget>(GetGameInstance(), WidgetClass);
+	}
+
+	// added to the viewport directly instead of AddToViewport, which removes it with the old world
+	if (LoadingWidget)
+	{
+		Viewport->AddViewportWidgetContent(LoadingWidget->TakeWidget(), 1000);
+	}
+}
+
+void UHappyTravelSubsystem::HideLoadingScreen()
+{
+	UGameViewportClient* Viewport = GetGameInstance()->GetGameViewportClient();
+	if (Viewport && LoadingWidget)
+	{
+		Viewport->RemoveViewportWidgetContent(LoadingWidget->TakeWidget());
+	}
+}
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "AnimNotify_HappyFootstep.generated.h"
+
+class USoundBase;
+
+/**
+ * Footstep placed on walk / run animations, played through UHappyAudioSubsystem's pool
+ */
+UCLASS(meta = (DisplayName = "Happy Footstep"))
+class HAPPYHAZARD_API UAnimNotify_HappyFootstep : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
+	virtual FString GetNotifyName_Implementation() const override;
+
+protected:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	TObjectPtr<USoundBase> Sound;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	FName FootSocketName = FName("foot_l");
+
+	// sprinting feet are louder
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	float ShiftVolumeMultiplier = 1.5f;
+};
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyAudioSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+struct FHappyGameplayEvent;
+
+UENUM(BlueprintType)
+enum class EHappySoundCategory : uint8
+{
+	Footstep,
+	Gunfire,
+	Effect,
+
+	Count UMETA(Hidden)
+};
+
+USTRUCT()
+struct FHappySoundCategorySettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	EHappySoundCategory Category = EHappySoundCategory::Effect;
+
+	// requests over this many playing voices are dropped
+	UPROPERTY(Config)
+	int32 MaxConcurrent = 8;
+
+	// requests farther than this from the listener are dropped (cm)
+	UPROPERTY(Config)
+	float MaxDistance = 3000.f;
+};
+
+/**
+ * Plays gameplay sounds through a fixed pool of audio components.
+ * Distance and per category concurrency are checked before a voice is taken,
+ * so culled requests never start a sound.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyAudioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Returns the pooled component playing the sound, or nullptr when it was culled */
+	UAudioComponent* PlaySound(USoundBase* Sound, EHappySoundCategory Category, const FVector& Location, float VolumeMultiplier = 1.f);
+
+	/** Caps the pool, voices above the new size finish playing and are then released */
+	void SetMaxPoolSize(int32 InMaxPoolSize);
+	int32 GetMaxPoolSize() const { return MaxPoolSize; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	int32 InitialPoolSize = 16;
+
+	UPROPERTY(Config)
+	int32 MaxPoolSize = 32;
+
+	UPROPERTY(Config)
+	TArray<FHappySoundCategorySettings> CategorySettings;
+
+private:
+	int32 AcquireComponent();
+	void ReleaseComponent(int32 PoolIndex);
+	UAudioComponent* CreatePooledComponent();
+	void OnPooledAudioFinished(UAudioComponent* Component);
+	void HandleWeaponEvents(TConstArrayView<FHappyGameplayEvent> Events);
+
+	const FHappySoundCategorySettings& GetSettings(EHappySoundCategory Category) const;
+
+	// slots past MaxPoolSize are emptied once their voice finishes
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> Pool;
+
+	TArray<EHappySoundCategory> PoolCategories;
+	TArray<bool> PoolInUse;
+	TArray<int32> FreeIndices;
+
+	int32 ActiveCounts[static_cast<int32>(EHappySoundCategory::Count)] = {};
+
+	FVector ListenerLocation = FVector::ZeroVector;
+	bool bHasListener = false;
+
+	int32 CulledThisFrame = 0;
+};
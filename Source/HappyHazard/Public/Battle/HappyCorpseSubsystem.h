@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyCorpseSubsystem.generated.h"
+
+class ACharacter;
+class UHappyCorpseSubsystem;
+
+enum class ECorpseState : uint8
+{
+	Simulating,
+	Sleeping,
+	Frozen
+};
+
+struct FCorpseSlot
+{
+	TWeakObjectPtr<ACharacter> Character;
+
+	ECorpseState State = ECorpseState::Simulating;
+
+	// world time the corpse was added, the oldest one is destroyed first
+	double AddedTime = 0.0;
+
+	// how long the ragdoll has been under the settle velocity (or asleep)
+	float SettledTime = 0.f;
+
+	bool IsInUse() const { return Character.IsValid(); }
+};
+
+/** Brackets the world's physics step so its wall time can be shown next to the simulated corpse bodies */
+USTRUCT()
+struct FHappyCorpsePhysicsTimerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UHappyCorpseSubsystem* Target = nullptr;
+	bool bPhysicsEnd = false;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FHappyCorpsePhysicsTimerTickFunction> : public TStructOpsTypeTraitsBase2<FHappyCorpsePhysicsTimerTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * Keeps dead characters from piling up physics cost.
+ * Only MaxSimulatingCorpses ragdolls simulate at once, settled ragdolls are put to sleep
+ * and then frozen into their last pose (no physics, no animation), and once MaxLiveCorpses
+ * is reached the oldest corpse is destroyed and its slot reused.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyCorpseSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Turn a dead character into a ragdoll managed by the corpse budget */
+	void AddCorpse(ACharacter* DeadCharacter);
+
+	/** Change the budget at runtime, extra corpses are frozen or destroyed right away */
+	void SetBudget(int32 InMaxSimulatingCorpses, int32 InMaxLiveCorpses);
+
+	int32 GetMaxSimulatingCorpses() const { return MaxSimulatingCorpses; }
+	int32 GetMaxLiveCorpses() const { return MaxLiveCorpses; }
+
+	/** Called by the physics timer tick functions around the physics step */
+	void MarkPhysicsStart();
+	void MarkPhysicsEnd();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	int32 MaxSimulatingCorpses = 8;
+
+	UPROPERTY(Config)
+	int32 MaxLiveCorpses = 24;
+
+	// ragdoll root speed (cm/s) under which the corpse counts as settled
+	UPROPERTY(Config)
+	float SettleSpeed = 5.f;
+
+	// seconds under SettleSpeed before the bodies are put to sleep
+	UPROPERTY(Config)
+	float SleepDelay = 0.5f;
+
+	// seconds asleep before the pose is frozen and physics is dropped
+	UPROPERTY(Config)
+	float FreezeDelay = 1.5f;
+
+private:
+	void StartRagdoll(ACharacter* DeadCharacter, bool bSimulate);
+	void SleepCorpse(FCorpseSlot& Slot);
+	void FreezeCorpse(FCorpseSlot& Slot);
+	// destroys the corpse actor (dead characters are not pooled) and frees its slot
+	void DestroyCorpse(FCorpseSlot& Slot);
+
+	int32 FindFreeSlot() const;
+	int32 FindOldestSlot(bool bSimulatingOnly) const;
+	int32 CountSimulating() const;
+	void EnforceBudget();
+
+	TArray<FCorpseSlot> Slots;
+
+	FHappyCorpsePhysicsTimerTickFunction PhysicsStartTickFunction;
+	FHappyCorpsePhysicsTimerTickFunction PhysicsEndTickFunction;
+	double PhysicsStartTime = 0.0;
+};
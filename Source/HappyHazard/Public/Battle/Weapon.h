@@ -7,6 +7,7 @@
 #include "Weapon.generated.h"
 
 class UBoxComponent;
+class USoundBase;
 
 UCLASS()
 class HAPPYHAZARD_API AWeapon : public AActor
@@ -27,9 +28,14 @@ protected:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
 	TObjectPtr<USkeletalMeshComponent> WeaponMesh;
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sound Parameter")
+	TObjectPtr<USoundBase> FireSound;
+
 
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	USoundBase* GetFireSound() const { return FireSound; }
+
 };
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyCharacterBatchSubsystem.generated.h"
+
+class AHappyHazardCharacter;
+class UHappyCharacterBatchSubsystem;
+
+/** Per character constants the camera and movement math needs */
+struct FHappyCharacterTuning
+{
+	float DefaultArmLength = 0.f;
+	float AimArmLength = 0.f;
+	float AimUpArmLength = 0.f;
+	float AimDownArmLength = 0.f;
+
+	FVector DefaultSocketPosition = FVector::ZeroVector;
+	FVector AimSocketPosition = FVector::ZeroVector;
+	FVector AimUpSocketPosition = FVector::ZeroVector;
+	FVector AimDownSocketPosition = FVector::ZeroVector;
+
+	float AimMoveSpeed = 0.f;
+	float DefaultMoveSpeed = 0.f;
+	float ShiftMoveSpeed = 0.f;
+};
+
+/**
+ * Pure per character math, shared by the per actor tick and the batched update.
+ * Nothing in here touches UObjects so it is safe to call from worker threads.
+ */
+namespace HappyCharacterLogic
+{
+	float StepAimingPercent(float AimingPercent, bool bAiming, float DeltaTime);
+
+	void SolveCameraBoom(const FHappyCharacterTuning& Tuning, float AimingPercent, bool bAiming, float AimPitch, float& OutArmLength, FVector& OutSocketOffset);
+
+	float StepMoveInput(float CurrentInput, float TargetInput);
+
+	float SolveMoveSpeed(const FHappyCharacterTuning& Tuning, bool bNowAiming, bool bNowShifting);
+}
+
+USTRUCT()
+struct FHappyCharacterBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UHappyCharacterBatchSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FHappyCharacterBatchTickFunction> : public TStructOpsTypeTraitsBase2<FHappyCharacterBatchTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * Runs the aim lerp, move speed and rotation sync of every registered character in one pass.
+ * State is gathered into flat arrays on the game thread, solved with ParallelFor,
+ * and written back to the components before character movement ticks.
+ */
+UCLASS()
+class HAPPYHAZARD_API UHappyCharacterBatchSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Returns false when batching is disabled, the character should then tick itself.
+	 *  A registered character's actor tick is disabled until it is unregistered */
+	bool RegisterCharacter(AHappyHazardCharacter* Character);
+	void UnregisterCharacter(AHappyHazardCharacter* Character);
+
+	/** Orders the batch after the character's new controller, so its input lands in the same frame */
+	void NotifyControllerChanged(AHappyHazardCharacter* Character);
+
+	/** The batch keeps a copy of each character's tuning, call when it was edited */
+	void RefreshTuning(AHappyHazardCharacter* Character);
+
+	void UpdateBatch(float DeltaTime);
+
+	/** For each count spawns that many characters, then compares game thread frame time over Frames frames
+	 *  with them ticking themselves against Frames frames batched. Logs the result when done */
+	void StartBenchmark(const TArray<int32>& Counts, int32 Frames);
+
+	bool IsBenchmarking() const { return BenchPhase != EBenchPhase::None || PendingBenchCounts.Num() > 0; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void GatherCharacters(float DeltaTime);
+	void SolveCharacters();
+	void ApplyCharacters();
+
+	enum class EBenchPhase : uint8
+	{
+		None,
+		PerActor,
+		Batched
+	};
+
+	void TickBenchmark();
+	void SpawnBenchCharacters(int32 Count);
+	void BeginBenchPhase(EBenchPhase Phase);
+
+	FHappyCharacterBatchTickFunction BatchTickFunction;
+
+	TArray<TWeakObjectPtr<AHappyHazardCharacter>> Characters;
+	TArray<FHappyCharacterTuning> Tunings;
+
+	// time since each character was last updated, characters honour their actor tick interval
+	TArray<float> PendingTimes;
+
+	// gathered from the game thread
+	TArray<uint8> Flags;
+	TArray<float> AimPitches;
+	TArray<float> ControlYaws;
+
+	// per character delta, the pending time when it is updated this frame
+	TArray<float> DeltaTimes;
+
+	// state carried by the character, copied in and out every update
+	TArray<float> AimingPercents;
+	TArray<float> MoveXInputs;
+	TArray<float> MoveYInputs;
+
+	// solved on worker threads
+	TArray<float> ArmLengths;
+	TArray<FVector> SocketOffsets;
+	TArray<float> MoveSpeeds;
+
+	// HappyHazard.BenchBatchTick, runs over real frames so tick dispatch is part of what is measured
+	TArray<int32> PendingBenchCounts;
+	TArray<TWeakObjectPtr<AHappyHazardCharacter>> BenchCharacters;
+	EBenchPhase BenchPhase = EBenchPhase::None;
+	int32 BenchFrames = 0;
+	int32 BenchFramesDone = 0;
+	double BenchGameThreadMs = 0.0;
+	double BenchPerActorMs = 0.0;
+};
@@ -11,10 +11,12 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
-class APlayerHUD;
 struct FInputActionValue;
 class AHappyPlayerController;
 class AWeapon;
+struct FHappyCharacterTuning;
+struct FHappyReplayStartState;
+enum class EHappyRecordedAction : uint8;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
@@ -23,6 +25,8 @@ class AHappyHazardCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend class UHappyCharacterBatchSubsystem;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	USpringArmComponent* CameraBoom;
@@ -66,7 +70,19 @@ public:
 	
 	virtual void Tick(float deltaTime) override;
 
+	/** Feeds a recorded action through the same handler live input uses */
+	void ReplayInput(EHappyRecordedAction Action, const FVector2D& AxisValue);
+
+	/** Everything the recorded input builds on: transform, view, velocity, aim/shift and the lerped move input */
+	void CaptureReplayState(FHappyReplayStartState& OutState) const;
+	void RestoreReplayState(const FHappyReplayStartState& State);
+
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
 protected:
+	// hands the handled input to UHappyInputReplaySubsystem while it records
+	void RecordInput(EHappyRecordedAction Action, const FInputActionValue& Value);
+
 
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
@@ -133,15 +149,22 @@ protected:
 	FRotator AimCameraRotation = FRotator(0.f, -40.f, 0.f);
 
 
-	void AimingLerp(float deltaTime);
-	void AimingPitchLerp(float deltaTime);
+	void AimingLerp(float deltaTime, const FHappyCharacterTuning& Tuning);
 
 
 	float moveXInput = 0.f;
 	float moveYInput = 0.f;
 	void SetMoveInputLerp(float aimmoveXInput, float aimmoveYInput);
 
-	void SetMoveSpeed();
+	void SetMoveSpeed(const FHappyCharacterTuning& Tuning);
+
+	/** Aim lerps, move speed and rotation sync. Done by UHappyCharacterBatchSubsystem instead when batched */
+	void TickCharacterLogic(float deltaTime);
+
+	FHappyCharacterTuning GetTuning() const;
+
+	// set by UHappyCharacterBatchSubsystem while it updates this character in place of the actor tick
+	bool bBatchTicked = false;
 
 protected:
 	// APawn interface
@@ -150,11 +173,19 @@ protected:
 	// To add mapping context
 	virtual void BeginPlay();
 
-	APlayerHUD* PlayerHUD;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void NotifyControllerChanged() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 
 	AHappyPlayerController* HappyPlayerController;
 
-	AWeapon* EquipWeapon;
+	// spawned on first equip and kept, aiming only shows and hides it
+	UPROPERTY()
+	TObjectPtr<AWeapon> EquipWeapon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Class Parameter", meta = (AllowPrivateAccess = "true"))
 	TSubclassOf<AWeapon> PistolClass;
@@ -164,7 +195,21 @@ protected:
 	bool bEquiped = false;
 
 
-	void SetUIUpdateTick();
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Health Parameter", meta = (AllowPrivateAccess = "true"))
+	float MaxHealth = 100.f;
+
+	float Health = 0.f;
+
+	bool bDead = false;
+
+	/** Stops the character and hands it to UHappyCorpseSubsystem as a ragdoll */
+	void Die();
+
+
+	// tells HUD and other listeners through the event bus when GetIsAiming() flips
+	void PushAimChangedEvent();
+
+	bool bLastAimingState = false;
 
 public:
 	/** Returns CameraBoom subobject **/
@@ -184,9 +229,26 @@ public:
 	UFUNCTION(BlueprintCallable)
 	float GetAimPitch() const;
 
+	UFUNCTION(BlueprintCallable)
+	float GetAimingPercent() const { return AimingPercent; }
+
 
 	UFUNCTION(BlueprintCallable)
 	bool GetIsShootable() const { return bShootable; }
 
+	UFUNCTION(BlueprintCallable)
+	bool GetIsShifting() const { return bNowShifting; }
+
+	UFUNCTION(BlueprintCallable)
+	bool GetIsDead() const { return bDead; }
+
+	/** Detaches the weapon and carried items and hands them to the controller so they survive seamless travel */
+	void ReleaseCarriedActors(TArray<AActor*>& OutActors);
+
+	/** Takes back an actor released by ReleaseCarriedActors on the other side of travel */
+	void AdoptCarriedActor(AActor* Actor);
+
+	static bool IsCarriedActor(const AActor* Actor);
+
 };
 
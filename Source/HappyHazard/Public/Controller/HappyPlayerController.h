@@ -14,4 +14,7 @@ class HAPPYHAZARD_API AHappyPlayerController : public APlayerController
 {
 	GENERATED_BODY()
 	
+public:
+	virtual void PlayerTick(float DeltaTime) override;
+
 };
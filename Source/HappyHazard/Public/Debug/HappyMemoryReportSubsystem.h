@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyMemoryReportSubsystem.generated.h"
+
+USTRUCT()
+struct FHappyMemoryBudget
+{
+	GENERATED_BODY()
+
+	// LLM tag name, e.g. HappyHazard/Character
+	UPROPERTY(Config)
+	FName Tag;
+
+	UPROPERTY(Config)
+	float BudgetMB = 0.f;
+};
+
+/**
+ * Dumps how much memory each HappyHazard LLM tag holds and flags tags over their configured budget.
+ * HappyHazard.MemReport prints it on demand. For a headless run:
+ *   HappyHazard ThirdPersonMap -game -nullrhi -llm -HappyMemReport=10 -HappyMemReportExit
+ * reports after 10 seconds of play and quits.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyMemoryReportSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Super::IsTickable() && ReportDelay >= 0.f; }
+
+	/** Returns the number of tags over budget */
+	int32 DumpReport() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	TArray<FHappyMemoryBudget> Budgets;
+
+private:
+	// seconds left before the command line report, negative when none is pending
+	float ReportDelay = -1.f;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+struct FEndLoadPackageContext;
+
+/**
+ * Breaks startup down into phases up to the first interactive frame, run with -HappyStartupProfile.
+ * Each phase records wall time, packages loaded and UObjects / physical memory gained while it ran.
+ * The breakdown goes to the log and as JSON to Saved/Profiling/HappyStartup so builds can be diffed,
+ * add -HappyStartupProfileExit for a headless launch (-nullrhi) that quits once it is written.
+ * The instrumented phases are also trace scopes, so they line up in Insights with -trace=cpu.
+ */
+class HAPPYHAZARD_API FHappyStartupProfiler
+{
+public:
+	struct FSnapshot
+	{
+		double Time = 0.0;
+		int32 PackagesLoaded = 0;
+		int32 NumObjects = 0;
+		uint64 UsedPhysical = 0;
+	};
+
+	static FHappyStartupProfiler& Get();
+
+	/** On while startup is being profiled, off for good once the report is written */
+	bool IsRecording() const { return bEnabled && !bFinished; }
+
+	void NotifyModuleStartup();
+
+	/** The local player's pawn has begun play, the next frame to finish is the first interactive one */
+	void NotifyPlayerReady();
+
+	FSnapshot TakeSnapshot() const;
+
+	/** Phases that run more than once (one per spawned character, etc.) are summed into one row */
+	void RecordPhase(const TCHAR* Name, const FSnapshot& Start);
+
+private:
+	FHappyStartupProfiler();
+
+	void HandleEndLoadPackage(const FEndLoadPackageContext& Context);
+	void HandlePostEngineInit();
+	void HandleEndFrame();
+
+	void Finish();
+	void WriteReport() const;
+
+	struct FPhase
+	{
+		FString Name;
+		double StartSeconds = 0.0;
+		double DurationMs = 0.0;
+		int32 PackagesLoaded = 0;
+		int32 ObjectsCreated = 0;
+		int64 MemoryDeltaBytes = 0;
+		int32 Count = 0;
+	};
+
+	TArray<FPhase> Phases;
+
+	FSnapshot ModuleStartup;
+	FSnapshot PlayerReady;
+
+	// async loading can finish packages off the game thread
+	std::atomic<int32> PackagesLoaded = 0;
+	int32 PackagesBeforeStartup = 0;
+
+	bool bEnabled = false;
+	bool bPlayerReady = false;
+	bool bFinished = false;
+
+	FDelegateHandle EndLoadPackageHandle;
+	FDelegateHandle EndFrameHandle;
+};
+
+/** Records the enclosing block as a startup phase while startup is being profiled */
+class HAPPYHAZARD_API FHappyStartupPhaseScope
+{
+public:
+	explicit FHappyStartupPhaseScope(const TCHAR* InName);
+	~FHappyStartupPhaseScope();
+
+private:
+	const TCHAR* Name;
+	FHappyStartupProfiler::FSnapshot Start;
+	bool bRecording;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Subsystems/WorldSubsystem.h"
+#include <atomic>
+#include "HappyGameplayEventBus.generated.h"
+
+enum class EHappyEventChannel : uint8
+{
+	Weapon,
+	Aim,
+	Pickup,
+	Noise,
+
+	Count
+};
+
+enum class EHappyEventType : uint8
+{
+	Fire,
+	AimChanged,		// Value is 1 when aiming started, 0 when it ended
+	PickedUp,
+	Noise,			// Value is loudness
+};
+
+/** Small by design, events are copied through the queue and into the per channel batches */
+struct FHappyGameplayEvent
+{
+	EHappyEventChannel Channel = EHappyEventChannel::Weapon;
+	EHappyEventType Type = EHappyEventType::Fire;
+
+	TWeakObjectPtr<AActor> Source;
+
+	FVector3f Location = FVector3f::ZeroVector;
+	float Value = 0.f;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHappyGameplayEvents, TConstArrayView<FHappyGameplayEvent>);
+
+/**
+ * Producers push events from any thread into a lock-free queue,
+ * and once per frame the game thread drains it and hands each channel's
+ * events to its listeners as one batch.
+ */
+UCLASS()
+class HAPPYHAZARD_API UHappyGameplayEventBus : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Safe to call from any thread */
+	void Push(const FHappyGameplayEvent& Event);
+
+	/** Game thread convenience, reads the source actor's location */
+	void Push(EHappyEventChannel Channel, EHappyEventType Type, AActor* Source, float Value = 0.f);
+
+	/** Game thread only, listeners are called from Tick with the frame's batch */
+	FOnHappyGameplayEvents& OnEvents(EHappyEventChannel Channel);
+
+	void DumpStats() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr int32 NumChannels = static_cast<int32>(EHappyEventChannel::Count);
+
+	TQueue<FHappyGameplayEvent, EQueueMode::Mpsc> PendingEvents;
+
+	FOnHappyGameplayEvents ChannelListeners[NumChannels];
+	TArray<FHappyGameplayEvent> ChannelBatches[NumChannels];
+
+	std::atomic<uint32> PushedCounts[NumChannels] = {};
+	uint64 DrainedTotals[NumChannels] = {};
+	int32 PeakBatchSizes[NumChannels] = {};
+};
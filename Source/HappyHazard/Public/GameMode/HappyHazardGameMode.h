@@ -13,6 +13,14 @@ class AHappyHazardGameMode : public AGameModeBase
 
 public:
 	AHappyHazardGameMode();
+
+	/** Keeps each player's weapon and carried items through the transition map */
+	virtual void GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList) override;
+
+	/** Hands the parked actors to the player's new pawn */
+	virtual void HandleSeamlessTravelPlayer(AController*& C) override;
+
+	virtual void PostSeamlessTravel() override;
 };
 
 
@@ -23,4 +23,8 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/** Announce the pickup on the event bus. Only reports it, what happens to the item (destroy, carry, pool) is up to the caller */
+	UFUNCTION(BlueprintCallable)
+	void NotifyPickedUp(AActor* Picker);
+
 };
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyPerformanceGovernor.generated.h"
+
+class ACharacter;
+
+/** Gameplay knobs for one fidelity level, level 0 is full fidelity */
+USTRUCT()
+struct FHappyFidelityTier
+{
+	GENERATED_BODY()
+
+	// actor tick interval for characters that are not the local player (0 = every frame)
+	UPROPERTY(Config)
+	float EnemyTickInterval = 0.f;
+
+	// mesh tick interval for those characters, which drives their anim update rate
+	UPROPERTY(Config)
+	float EnemyAnimTickInterval = 0.f;
+
+	// perception queries AI may run per frame
+	UPROPERTY(Config)
+	int32 PerceptionBudget = 32;
+
+	UPROPERTY(Config)
+	int32 MaxAudioPoolSize = 32;
+
+	UPROPERTY(Config)
+	int32 MaxSimulatingCorpses = 8;
+
+	UPROPERTY(Config)
+	int32 MaxLiveCorpses = 24;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHappyFidelityChanged, int32 /*Level*/);
+
+/**
+ * Watches rolling frame and game thread time against a target and steps gameplay fidelity
+ * down when over it and back up when well under it. Asymmetric bands, hold times and a cooldown
+ * keep it from bouncing between levels.
+ * Test it headless with HappyHazard.Governor.InjectLoadMs, decisions go to the log and "stat HappyHazard".
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyPerformanceGovernor : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	int32 GetLevel() const { return Level; }
+	const FHappyFidelityTier& GetTier() const { return Tiers[Level]; }
+
+	/** Knobs new enemies should read when they spawn */
+	float GetEnemyTickInterval() const { return GetTier().EnemyTickInterval; }
+	float GetEnemyAnimTickInterval() const { return GetTier().EnemyAnimTickInterval; }
+	int32 GetPerceptionBudget() const { return GetTier().PerceptionBudget; }
+
+	/** Sets the enemy tick rates of the current tier on one character, or full rate for the local player.
+	 *  Characters call it on begin play and when their controller changes */
+	void ApplyTierToCharacter(ACharacter* Character) const;
+
+	FOnHappyFidelityChanged OnFidelityChanged;
+
+	void DumpStatus() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	float TargetFrameMs = 16.6f;
+
+	// step down when the rolling average is this fraction over target
+	UPROPERTY(Config)
+	float DegradeThreshold = 0.1f;
+
+	// step up when the rolling average is this fraction under target
+	UPROPERTY(Config)
+	float RestoreThreshold = 0.2f;
+
+	UPROPERTY(Config)
+	float DegradeHoldSeconds = 1.f;
+
+	UPROPERTY(Config)
+	float RestoreHoldSeconds = 4.f;
+
+	// no further change for this long after a change, lets the new level show in the average
+	UPROPERTY(Config)
+	float CooldownSeconds = 2.f;
+
+	UPROPERTY(Config)
+	int32 SampleWindow = 60;
+
+	UPROPERTY(Config)
+	TArray<FHappyFidelityTier> Tiers;
+
+private:
+	void AddSample(float FrameMs, float GameThreadMs);
+	void SetLevel(int32 NewLevel, const TCHAR* Reason);
+	void ApplyTier();
+
+	TArray<float> FrameSamples;
+	TArray<float> GameThreadSamples;
+	int32 NextSample = 0;
+	float FrameSum = 0.f;
+	float GameThreadSum = 0.f;
+
+	float AverageFrameMs = 0.f;
+	float AverageGameThreadMs = 0.f;
+
+	int32 Level = 0;
+	float OverTime = 0.f;
+	float UnderTime = 0.f;
+	float CooldownLeft = 0.f;
+
+	// wall clock of the previous tick, real frame time regardless of time dilation or a fixed timestep
+	double LastTickTime = 0.0;
+};
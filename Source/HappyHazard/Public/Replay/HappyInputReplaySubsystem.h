@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyInputReplaySubsystem.generated.h"
+
+class AHappyPlayerController;
+class AHappyHazardCharacter;
+
+/** One bit per action in FHappyInputFrame::ActionMask */
+enum class EHappyRecordedAction : uint8
+{
+	Move,
+	Look,
+	AimStart,
+	AimEnd,
+	Fire,
+	ShiftStart,
+	ShiftEnd,
+
+	Count
+};
+
+struct FHappyInputFrame
+{
+	float DeltaTime = 0.f;
+	uint8 ActionMask = 0;
+
+	// only written to the file when the Move / Look bit is set
+	FVector2f Move = FVector2f::ZeroVector;
+	FVector2f Look = FVector2f::ZeroVector;
+
+	bool HasAction(EHappyRecordedAction Action) const { return (ActionMask & (1 << static_cast<uint8>(Action))) != 0; }
+	void AddAction(EHappyRecordedAction Action) { ActionMask |= (1 << static_cast<uint8>(Action)); }
+
+	friend FArchive& operator<<(FArchive& Ar, FHappyInputFrame& Frame);
+};
+
+/** Pawn, view and character movement state at the first recorded frame, restored before replay starts */
+struct FHappyReplayStartState
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FRotator ControlRotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+
+	bool bAiming = false;
+	bool bShifting = false;
+	float AimingPercent = 0.f;
+	FVector2f MoveInput = FVector2f::ZeroVector;
+
+	friend FArchive& operator<<(FArchive& Ar, FHappyReplayStartState& State);
+};
+
+/**
+ * Records the Enhanced Input actions the character handled each frame into a small binary file,
+ * and plays a file back through the same handlers with the recorded frame times as a fixed timestep.
+ * Start a headless replay with -HappyReplay=<file> (add -HappyReplayExit to quit when it ends).
+ */
+UCLASS()
+class HAPPYHAZARD_API UHappyInputReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	bool StartRecording(AHappyPlayerController* Controller, const FString& FilePath);
+	void StopRecording();
+
+	bool StartReplay(AHappyPlayerController* Controller, const FString& FilePath);
+	void StopReplay();
+
+	bool IsRecording() const { return bRecording; }
+	bool IsReplaying() const { return ReplayController.IsValid(); }
+
+	/** Called by the character's input handlers while recording */
+	void RecordAction(EHappyRecordedAction Action, const FVector2D& Value);
+
+	/** Called by AHappyPlayerController before input is processed */
+	void PreControllerTick(AHappyPlayerController* Controller, float DeltaTime);
+
+	/** Called by AHappyPlayerController after input is processed */
+	void PostControllerTick(AHappyPlayerController* Controller, float DeltaTime);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	bool SaveRecording() const;
+	bool LoadRecording(const FString& FilePath);
+
+	void FeedFrame(AHappyHazardCharacter* Character, const FHappyInputFrame& Frame);
+
+	TWeakObjectPtr<AHappyPlayerController> RecordController;
+	TWeakObjectPtr<AHappyPlayerController> ReplayController;
+
+	FString RecordFilePath;
+
+	// kept apart from RecordController so a recording whose controller is gone is still saved
+	bool bRecording = false;
+	bool bRecordStartPending = false;
+
+	FHappyReplayStartState StartState;
+
+	TArray<FHappyInputFrame> Frames;
+	FHappyInputFrame PendingFrame;
+
+	int32 ReplayFrameIndex = INDEX_NONE;
+	uint64 ReplayRequestFrame = 0;
+	double ReplayStartTime = 0.0;
+
+	bool bSavedUseFixedTimeStep = false;
+	double SavedFixedDeltaTime = 0.0;
+
+	bool bCheckedCommandLine = false;
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HappyKillcamProxy.generated.h"
+
+class USkeletalMeshComponent;
+class USpringArmComponent;
+class UCameraComponent;
+
+/**
+ * Stand-in for a recorded character during killcam playback.
+ * UHappyKillcamSubsystem moves it every frame, an anim blueprint can read the aim getters.
+ */
+UCLASS()
+class HAPPYHAZARD_API AHappyKillcamProxy : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AHappyKillcamProxy();
+
+	void SetupMesh(USkeletalMesh* SkeletalMesh, const FTransform& RelativeTransform, UClass* AnimClass);
+
+	void ApplyFrame(const FVector& Location, const FRotator& Rotation, float InAimingPercent, float InAimPitch);
+
+	void NotifyFired();
+
+	UFUNCTION(BlueprintCallable)
+	float GetAimingPercent() const { return AimingPercent; }
+
+	UFUNCTION(BlueprintCallable)
+	float GetAimPitch() const { return AimPitch; }
+
+protected:
+	// hook for muzzle flash and sound on the proxy
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnFired();
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	TObjectPtr<USkeletalMeshComponent> Mesh;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	TObjectPtr<USpringArmComponent> CameraBoom;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	TObjectPtr<UCameraComponent> Camera;
+
+	float AimingPercent = 0.f;
+	float AimPitch = 0.f;
+
+};
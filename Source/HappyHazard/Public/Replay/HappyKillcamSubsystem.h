@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyKillcamSubsystem.generated.h"
+
+class ACharacter;
+class AHappyKillcamProxy;
+class UAnimInstance;
+class USkeletalMesh;
+struct FHappyGameplayEvent;
+
+enum class EHappyKillcamFlags : uint8
+{
+	None = 0,
+	Fired = 1 << 0,		// weapon fire event from the character since the last sample
+	Aiming = 1 << 1,
+};
+ENUM_CLASS_FLAGS(EHappyKillcamFlags);
+
+/** 14 bytes, position is a delta from the previous sample in PositionQuantum steps */
+struct FHappyKillcamSample
+{
+	// ms since the chunk's StartTime, samples are taken at most once a frame so they drift off the nominal rate
+	uint16 TimeOffsetMs = 0;
+	int16 DeltaX = 0;
+	int16 DeltaY = 0;
+	int16 DeltaZ = 0;
+	uint16 Yaw = 0;
+	uint16 Pitch = 0;
+	uint8 AimingPercent = 0;
+	EHappyKillcamFlags Flags = EHappyKillcamFlags::None;
+};
+
+/** SampleRate samples (a second at full rate), decodable on its own from the keyframe */
+struct FHappyKillcamChunk
+{
+	FVector3f KeyLocation = FVector3f::ZeroVector;
+	double StartTime = 0.0;
+	int32 NumSamples = 0;
+};
+
+/** Fixed size ring of chunks for one character, sized once and reused */
+struct FHappyKillcamTrack
+{
+	TWeakObjectPtr<ACharacter> Character;
+	FName CharacterName;
+
+	// what the proxy needs once the character may be gone
+	TWeakObjectPtr<USkeletalMesh> Mesh;
+	FTransform MeshRelativeTransform;
+
+	TArray<FHappyKillcamChunk> Chunks;
+	TArray<FHappyKillcamSample> Samples;
+
+	int32 HeadChunk = INDEX_NONE;
+	int32 NumChunksUsed = 0;
+
+	// where the decoder will be after the last sample, deltas are taken from here so error doesn't build up
+	FVector3f LastEncodedLocation = FVector3f::ZeroVector;
+
+	EHappyKillcamFlags PendingFlags = EHappyKillcamFlags::None;
+
+	// recording resumed after a gap (playback), the next sample starts a new chunk
+	bool bNeedsKeyframe = false;
+
+	double RecordStartTime = 0.0;
+	double LastSampleTime = 0.0;
+	uint64 BytesWritten = 0;
+
+	bool IsInUse() const { return HeadChunk != INDEX_NONE; }
+};
+
+/**
+ * Keeps the last few seconds of every character (transform, aim and weapon fire) in fixed memory
+ * for death cams and bug reports, and plays them back on AHappyKillcamProxy actors.
+ * Samples are quantized and delta encoded into per character rings allocated at begin play,
+ * recording never allocates. HappyHazard.Killcam.Stats reports bytes per second per character.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyKillcamSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Plays the last Seconds back on proxies, viewed from the proxy of the track recorded as FocusName.
+	 * Without a name it follows the character the local player controlled last, which is still buffered after it died.
+	 * Recording pauses meanwhile
+	 */
+	bool StartPlayback(float Seconds, FName FocusName = NAME_None);
+	void StopPlayback();
+
+	/** Plays the last DeathPlaybackSeconds from the victim's view when it was the local player's character */
+	void NotifyCharacterDied(ACharacter* Victim);
+
+	bool IsPlayingBack() const { return PlaybackProxies.Num() > 0; }
+
+	void DumpStats() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	int32 SampleRate = 30;
+
+	UPROPERTY(Config)
+	int32 BufferSeconds = 10;
+
+	// tracks are allocated up front, characters past this are not recorded
+	UPROPERTY(Config)
+	int32 MaxTrackedCharacters = 16;
+
+	// 0 turns the death cam off
+	UPROPERTY(Config)
+	float DeathPlaybackSeconds = 5.f;
+
+	// optional anim blueprint for the proxies, reading AHappyKillcamProxy's getters
+	UPROPERTY(Config)
+	TSoftClassPtr<UAnimInstance> ProxyAnimClass;
+
+private:
+	struct FDecodedFrame
+	{
+		double Time = 0.0;
+		FVector Location = FVector::ZeroVector;
+		FRotator Rotation = FRotator::ZeroRotator;
+		float AimingPercent = 0.f;
+		float AimPitch = 0.f;
+		EHappyKillcamFlags Flags = EHappyKillcamFlags::None;
+	};
+
+	struct FPlaybackProxy
+	{
+		TWeakObjectPtr<AHappyKillcamProxy> Proxy;
+		TArray<FDecodedFrame> Frames;
+		int32 Cursor = 0;
+	};
+
+	void OnActorSpawned(AActor* Actor);
+	void AddCharacter(ACharacter* Character);
+	void HandleWeaponEvents(TConstArrayView<FHappyGameplayEvent> Events);
+
+	void RecordSample(FHappyKillcamTrack& Track, double Time);
+	void DecodeTrack(const FHappyKillcamTrack& Track, double FromTime, TArray<FDecodedFrame>& OutFrames) const;
+	void TickPlayback(float DeltaTime);
+
+	FHappyKillcamTrack* FindTrack(const ACharacter* Character);
+
+	int32 GetSamplesPerChunk() const { return FMath::Max(SampleRate, 1); }
+
+	TArray<FHappyKillcamTrack> Tracks;
+
+	float SampleInterval = 0.f;
+	float TimeUntilSample = 0.f;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	TArray<FPlaybackProxy> PlaybackProxies;
+	double PlaybackTime = 0.0;
+	double PlaybackEndTime = 0.0;
+	TWeakObjectPtr<AActor> SavedViewTarget;
+
+	// track of the local player's pawn at the last sample, the pawn itself is gone or replaced after death
+	FName LastPlayerTrackName;
+};
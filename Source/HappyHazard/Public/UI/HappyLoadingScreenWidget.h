@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "HappyLoadingScreenWidget.generated.h"
+
+/**
+ * Default loading screen for UHappyTravelSubsystem: black background with a "Loading..." line.
+ * Built in code so travel always has something to show, a designed widget can replace it through LoadingWidgetClass.
+ */
+UCLASS()
+class HAPPYHAZARD_API UHappyLoadingScreenWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+};
@@ -7,6 +7,7 @@
 #include "PlayerHUD.generated.h"
 
 class UAimCrossHairWidget;
+struct FHappyGameplayEvent;
 /**
  * 
  */
@@ -23,6 +24,10 @@ public:
 protected:
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void HandleAimEvents(TConstArrayView<FHappyGameplayEvent> Events);
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Widget Parameter", meta = (AllowPrivateAccess = "true"))
 	TSubclassOf<UAimCrossHairWidget> AimCrossHairWidgetClass;
 
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HappyDoor.generated.h"
+
+class UBoxComponent;
+class AHappyRoomVolume;
+
+/**
+ * Door between two rooms. The player walking up to it is a strong hint for the next room,
+ * so it asks the room streaming to bring the other side in early.
+ * A plain actor with its own approach trigger, not an item: it is never picked up or carried.
+ */
+UCLASS()
+class HAPPYHAZARD_API AHappyDoor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHappyDoor();
+
+	/** The room on the other side of the door from Point */
+	AHappyRoomVolume* GetOtherRoom(const FVector& Point) const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	UFUNCTION()
+	void OnApproachBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	TObjectPtr<UBoxComponent> ApproachTrigger;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Door Parameter")
+	TObjectPtr<AHappyRoomVolume> RoomA;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Door Parameter")
+	TObjectPtr<AHappyRoomVolume> RoomB;
+};
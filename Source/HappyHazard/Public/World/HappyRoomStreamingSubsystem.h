@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HappyRoomStreamingSubsystem.generated.h"
+
+class AHappyRoomVolume;
+class APawn;
+class ULevelStreaming;
+
+struct FHappyRoomStreamingState
+{
+	TWeakObjectPtr<AHappyRoomVolume> Room;
+	TWeakObjectPtr<ULevelStreaming> Streaming;
+
+	bool bResident = false;
+	bool bVisible = false;
+
+	// in the current room's neighbourhood or predicted, never unloaded for budget
+	bool bWanted = false;
+
+	double RequestTime = 0.0;
+	double LastWantedTime = 0.0;
+
+	// for the load log
+	float MaxFrameMsWhileLoading = 0.f;
+	uint64 UsedPhysicalAtRequest = 0;
+	bool bEnteredBeforeVisible = false;
+};
+
+/**
+ * Keeps the room the player is in, its neighbours and the room the player is heading to streamed in.
+ * The next room is predicted from the movement direction and from the last door the player walked up to.
+ * Rooms outside that set stay resident as a cache until the estimated memory goes over ResidentBudgetMB,
+ * then the farthest ones (by door count) are unloaded first.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyRoomStreamingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterRoom(AHappyRoomVolume* Room);
+	void UnregisterRoom(AHappyRoomVolume* Room);
+
+	/** A door the player walked up to, NextRoom is the side they are not in */
+	void NotifyDoorApproached(AHappyRoomVolume* NextRoom);
+
+	AHappyRoomVolume* GetCurrentRoom() const { return CurrentRoom.Get(); }
+
+	void DumpRooms() const;
+
+	/** PIE check for the entered before visible warning: teleports the player into a room that isn't resident */
+	void EnterColdRoom();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Config)
+	float ResidentBudgetMB = 512.f;
+
+	UPROPERTY(Config)
+	float UpdateInterval = 0.2f;
+
+	// slower than this (cm/s) and the movement direction is not trusted for prediction
+	UPROPERTY(Config)
+	float PredictMinSpeed = 100.f;
+
+	// how well the movement direction has to point at a neighbour to pick it (cosine)
+	UPROPERTY(Config)
+	float PredictMinDot = 0.5f;
+
+	UPROPERTY(Config)
+	float DoorHintSeconds = 5.f;
+
+private:
+	void UpdateWantedRooms();
+	void UpdateLoadProgress(float DeltaTime);
+	void EnforceBudget();
+
+	void RequestLoad(FHappyRoomStreamingState& State);
+	void RequestUnload(FHappyRoomStreamingState& State);
+
+	ULevelStreaming* FindOrCreateStreaming(AHappyRoomVolume* Room);
+	FHappyRoomStreamingState* FindState(const AHappyRoomVolume* Room);
+	AHappyRoomVolume* PredictNextRoom(const APawn* Pawn) const;
+
+	/** Door count from the current room to every room, unreachable rooms are left out */
+	TMap<const AHappyRoomVolume*, int32> ComputeRoomDistances() const;
+
+	TArray<FHappyRoomStreamingState> Rooms;
+
+	TWeakObjectPtr<AHappyRoomVolume> CurrentRoom;
+	TWeakObjectPtr<AHappyRoomVolume> DoorHintRoom;
+	double DoorHintTime = 0.0;
+
+	float TimeUntilUpdate = 0.f;
+};
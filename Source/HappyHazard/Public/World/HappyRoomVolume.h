@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HappyRoomVolume.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Marks out one mansion room in the persistent level and names the sublevel holding its content.
+ * UHappyRoomStreamingSubsystem streams that sublevel in and out around the player.
+ */
+UCLASS()
+class HAPPYHAZARD_API AHappyRoomVolume : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AHappyRoomVolume();
+
+	bool ContainsPoint(const FVector& Point) const;
+
+	const TSoftObjectPtr<UWorld>& GetRoomLevel() const { return RoomLevel; }
+	const TArray<TObjectPtr<AHappyRoomVolume>>& GetNeighbours() const { return Neighbours; }
+	float GetEstimatedMemoryMB() const { return EstimatedMemoryMB; }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+	TObjectPtr<UBoxComponent> RoomBounds;
+
+	// sublevel with this room's meshes, lights and props
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Room Parameter")
+	TSoftObjectPtr<UWorld> RoomLevel;
+
+	// rooms reachable through a door from this one
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Room Parameter")
+	TArray<TObjectPtr<AHappyRoomVolume>> Neighbours;
+
+	// resident cost counted against the streaming budget, measure with memreport and keep up to date
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Room Parameter")
+	float EstimatedMemoryMB = 64.f;
+
+};
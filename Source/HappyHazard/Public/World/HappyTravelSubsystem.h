@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Engine/TimerHandle.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#include "HappyTravelSubsystem.generated.h"
+
+class UUserWidget;
+
+/**
+ * Map travel behind a loading screen. The destination package and everything it references are
+ * loaded asynchronously first while the loading widget is up, then seamless travel is started so
+ * the actual level switch finds it all in memory. Load-to-playable time is logged when
+ * AHappyHazardGameMode reports the players restarted in the new map.
+ */
+UCLASS(config=Game)
+class HAPPYHAZARD_API UHappyTravelSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** MapName is a long package name, e.g. /Game/ThirdPerson/Maps/ThirdPersonMap */
+	void TravelTo(const FString& MapName);
+
+	void NotifyTravelFinished(UWorld* World);
+
+	bool IsTraveling() const { return bTraveling; }
+
+protected:
+	// shown from the travel request until the new map is playable, UHappyLoadingScreenWidget when not set
+	UPROPERTY(Config)
+	TSoftClassPtr<UUserWidget> LoadingWidgetClass;
+
+	// keep the loading screen up at least this long so it doesn't flash on fast loads
+	UPROPERTY(Config)
+	float MinLoadingScreenSeconds = 0.5f;
+
+private:
+	void OnDestinationPreloaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result);
+	void StartTravel();
+	void HandleTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString);
+
+	void ShowLoadingScreen();
+	void HideLoadingScreen();
+
+	UPROPERTY()
+	TObjectPtr<UUserWidget> LoadingWidget;
+
+	// held so the preloaded map isn't collected before travel picks it up
+	UPROPERTY()
+	TObjectPtr<UPackage> PreloadedPackage;
+
+	FString DestinationMap;
+	bool bTraveling = false;
+
+	double RequestTime = 0.0;
+	double PreloadedTime = 0.0;
+
+	FTimerHandle TravelTimerHandle;
+};